@@ -0,0 +1,340 @@
+// Records allocation traces and replays them against every allocator in the tree and malloc.
+// g++ -std=c++20 -O2 -DNDEBUG main.cpp -o allocator_bench
+//   allocator_bench record <file> [operations] [seed]   writes a synthetic server-like trace
+//   allocator_bench replay <file>                        replays a trace
+//   allocator_bench                                      records a default trace in memory and replays it
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "trace.h"
+#include "../memory_manager/memory_manager.h"
+#include "../memory_manager/small_memory.h"
+#include "../pool/pool.h"
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    struct malloc_allocator
+    {
+        static constexpr const char* name = "malloc";
+
+        void* allocate(size_t size) {return malloc(size);}
+        void  release(void* p, size_t) {free(p);}
+    };
+
+    struct owl_allocator
+    {
+        static constexpr const char* name = "owl::memory";
+
+        owl::memory mem;
+
+        owl_allocator() {mem.init(size_t(4) << 30);}
+        ~owl_allocator() {mem.terminate();}
+
+        void* allocate(size_t size) {return mem.allocate(size);}
+        void  release(void* p, size_t) {mem.free_block(owl::memory::block_of(p));}
+    };
+
+    struct small_allocator
+    {
+        static constexpr const char* name = "owl::small_memory";
+
+        owl::memory mem;
+        owl::small_memory small;
+
+        small_allocator()
+        {
+            mem.init(size_t(4) << 30);
+            small.init(mem);
+        }
+        ~small_allocator()
+        {
+            small.terminate();
+            mem.terminate();
+        }
+
+        void* allocate(size_t size) {return small.allocate(size);}
+        void  release(void* p, size_t size) {small.deallocate(p, size);}
+    };
+
+    template <size_t N>
+    struct alignas(16) chunk
+    {
+        unsigned char bytes[N];
+    };
+
+    // ecs::Pool is fixed size, so the trace is served by one pool per power of two from 16 bytes to 64 KB.
+    // Bigger requests fall back to malloc.
+    template <size_t... I>
+    struct pool_set
+    {
+        static constexpr size_t classes = sizeof...(I);
+        static constexpr size_t max_size = size_t(16) << (classes - 1);
+
+        template <size_t K>
+        using pool = ecs::Pool<chunk<(size_t(16) << K)>>;
+
+        // every slab holds about 1 MB
+        std::tuple<std::unique_ptr<pool<I>>...> pools{std::make_unique<pool<I>>(std::max<size_t>(16, (size_t(1) << 20) >> (4 + I)))...};
+
+        static unsigned class_of(size_t size)
+        {
+            return size <= 16 ? 0 : 64 - (unsigned)__builtin_clzll((unsigned long long)(size - 1)) - 4;
+        }
+
+        void* allocate(size_t size)
+        {
+            if (size > max_size) return malloc(size);
+            static constexpr void* (*allocs[])(pool_set&) = {[](pool_set& s) -> void* {return std::get<I>(s.pools)->allocate();}...};
+            return allocs[class_of(size)](*this);
+        }
+
+        void release(void* p, size_t size)
+        {
+            if (size > max_size) return free(p);
+            static constexpr void (*frees[])(pool_set&, void*) = {[](pool_set& s, void* q) {std::get<I>(s.pools)->deallocate(static_cast<chunk<(size_t(16) << I)>*>(q));}...};
+            frees[class_of(size)](*this, p);
+        }
+    };
+
+    struct pool_allocator : pool_set<0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12>
+    {
+        static constexpr const char* name = "ecs::Pool";
+    };
+
+    // Server-like workload recorded through malloc: mostly short lived small requests, a tail of large ones
+    // and one in five objects living for a long time
+    std::vector<trace::record> record_synthetic(size_t operations, unsigned seed)
+    {
+        trace::recorder rec;
+        std::mt19937_64 rng(seed);
+        typedef std::pair<size_t, void*> death;
+        std::priority_queue<death, std::vector<death>, std::greater<death>> dying;
+
+        for (size_t step=0; step<operations; step++)
+        {
+            unsigned kind = rng()%100;
+            size_t size = kind < 70 ? 8 + rng()%248 : kind < 95 ? 256 + rng()%3840 : 4096 + rng()%61440;
+            size_t lifetime = rng()%5 == 0 ? 1 + rng()%200000 : 1 + rng()%200;
+            void* p = malloc(size);
+            rec.on_allocate(p, size);
+            dying.push({step + lifetime, p});
+
+            while (!dying.empty() && dying.top().first <= step)
+            {
+                rec.on_free(dying.top().second);
+                free(dying.top().second);
+                dying.pop();
+            }
+        }
+        while (!dying.empty())
+        {
+            rec.on_free(dying.top().second);
+            free(dying.top().second);
+            dying.pop();
+        }
+        return rec.records();
+    }
+
+    struct trace_info
+    {
+        uint32_t ids = 0;
+        size_t   peak_live = 0;     // requested bytes
+        std::vector<uint32_t> sizes;    // by id
+    };
+
+    trace_info inspect(const std::vector<trace::record>& records)
+    {
+        trace_info info;
+        for (const trace::record& r : records)
+        {
+            if (r.id >= info.ids) info.ids = r.id + 1;
+        }
+        info.sizes.assign(info.ids, 0);
+        size_t live = 0;
+        for (const trace::record& r : records)
+        {
+            if (r.op == trace::record::allocate)
+            {
+                info.sizes[r.id] = r.size;
+                live += r.size;
+                info.peak_live = std::max(info.peak_live, live);
+            }
+            else
+            {
+                live -= info.sizes[r.id];
+            }
+        }
+        return info;
+    }
+
+    double rss_mb()
+    {
+        FILE* f = fopen("/proc/self/statm", "r");
+        if (!f) return 0;
+        unsigned long pages = 0, resident = 0;
+        int n = fscanf(f, "%lu %lu", &pages, &resident);
+        fclose(f);
+        return n == 2 ? resident * 4096.0 / (1 << 20) : 0;
+    }
+
+    double peak_rss_mb()
+    {
+#if defined(__linux__)
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss / 1024.0;
+#else
+        return 0;
+#endif
+    }
+
+    // Writes one byte per page like a program filling the allocation would, so the RSS reflects the footprint
+    inline void* touch(void* p, size_t size)
+    {
+        for (size_t offset=0; offset<size; offset+=4096) ((volatile char*)p)[offset] = 1;
+        return p;
+    }
+
+    // Replays once for throughput, then again timing every operation.
+    // Fragmentation is the share of the peak RSS growth not explained by live requested bytes.
+    template <class A>
+    void replay(const std::vector<trace::record>& records, const trace_info& info)
+    {
+        std::vector<void*> ptrs(info.ids);
+        std::vector<float> latency(records.size());
+        double base_rss = rss_mb();
+        A alloc;
+
+        auto startTime = std::chrono::steady_clock::now();
+        for (const trace::record& r : records)
+        {
+            if (r.op == trace::record::allocate)
+            {
+                ptrs[r.id] = touch(alloc.allocate(r.size), r.size);
+            }
+            else
+            {
+                alloc.release(ptrs[r.id], info.sizes[r.id]);
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        for (size_t i=0; i<records.size(); i++)
+        {
+            const trace::record& r = records[i];
+            auto opStart = std::chrono::steady_clock::now();
+            if (r.op == trace::record::allocate)
+            {
+                ptrs[r.id] = touch(alloc.allocate(r.size), r.size);
+            }
+            else
+            {
+                alloc.release(ptrs[r.id], info.sizes[r.id]);
+            }
+            latency[i] = std::chrono::duration<float, std::nano>(std::chrono::steady_clock::now() - opStart).count();
+        }
+
+        double peak_rss = peak_rss_mb() - base_rss;
+        double live_mb = info.peak_live / double(1 << 20);
+        double fragmentation = peak_rss > live_mb ? 1.0 - live_mb / peak_rss : 0.0;
+
+        auto percentile = [&](double q)
+        {
+            size_t k = std::min(latency.size() - 1, (size_t)(latency.size() * q));
+            std::nth_element(latency.begin(), latency.begin() + k, latency.end());
+            return latency[k];
+        };
+        double p50 = percentile(0.5), p99 = percentile(0.99), p999 = percentile(0.999);
+        std::printf("%-18s %10.2f %9.0f %9.0f %9.0f %10.1f %8.3f\n", A::name, records.size() / seconds / 1e6, p50, p99, p999, peak_rss, fragmentation);
+        std::fflush(stdout);
+    }
+
+    // Each allocator runs in its own process so the peak RSS is its own
+    template <class A>
+    void replay_isolated(const std::vector<trace::record>& records, const trace_info& info)
+    {
+#if defined(__linux__)
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            replay<A>(records, info);
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) std::printf("%-18s failed\n", A::name);
+#else
+        replay<A>(records, info);
+#endif
+    }
+
+    void replay_all(const std::vector<trace::record>& records)
+    {
+        trace_info info = inspect(records);
+#if defined(__GLIBC__)
+        // hand back what recording left in the malloc heap, or the replays would reuse it as already resident
+        malloc_trim(0);
+#endif
+        std::printf("%zu operations, %u allocations, peak live %.1f MB\n", records.size(), info.ids, info.peak_live / double(1 << 20));
+        std::printf("%-18s %10s %9s %9s %9s %10s %8s\n", "allocator", "Mops/s", "p50 ns", "p99 ns", "p999 ns", "peak MB", "frag");
+        std::fflush(stdout);
+        replay_isolated<malloc_allocator>(records, info);
+        replay_isolated<owl_allocator>(records, info);
+        replay_isolated<small_allocator>(records, info);
+        replay_isolated<pool_allocator>(records, info);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "record" && argc > 2)
+    {
+        size_t operations = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1000000;
+        unsigned seed = argc > 4 ? (unsigned)std::strtoul(argv[4], nullptr, 10) : 2024;
+        if (!trace::save(argv[2], record_synthetic(operations, seed)))
+        {
+            std::fprintf(stderr, "cannot write %s\n", argv[2]);
+            return 1;
+        }
+        return 0;
+    }
+    if (mode == "replay" && argc > 2)
+    {
+        std::vector<trace::record> records = trace::load(argv[2]);
+        if (records.empty())
+        {
+            std::fprintf(stderr, "cannot read %s\n", argv[2]);
+            return 1;
+        }
+        replay_all(records);
+        return 0;
+    }
+    if (!mode.empty())
+    {
+        std::fprintf(stderr, "usage: %s [record <file> [operations] [seed] | replay <file>]\n", argv[0]);
+        return 1;
+    }
+
+    replay_all(record_synthetic(1000000, 2024));
+    return 0;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Allocation traces: every allocation gets an id, a free names the id it releases.
+// File layout, little endian: "ATRC", uint32 version, uint64 record count, then 10 byte records
+//   uint8 op (0 allocate, 1 free), uint8 thread, uint32 id, uint32 size (0 for frees)
+// Lifetimes are the distance between an allocate and the free with the same id.
+namespace trace
+{
+    struct record
+    {
+        enum kind : uint8_t { allocate, free };
+
+        kind     op;
+        uint8_t  thread;
+        uint32_t id;
+        uint32_t size;
+    };
+
+    const uint32_t version = 1;
+    const size_t   record_bytes = 10;
+
+    inline bool save(const char* path, const std::vector<record>& records)
+    {
+        FILE* f = std::fopen(path, "wb");
+        if (!f) return false;
+        uint8_t header[16] = {'A', 'T', 'R', 'C'};
+        uint64_t count = records.size();
+        for (int i=0; i<4; i++) header[4+i] = uint8_t(version >> (8*i));
+        for (int i=0; i<8; i++) header[8+i] = uint8_t(count >> (8*i));
+        bool ok = std::fwrite(header, 1, sizeof(header), f) == sizeof(header);
+
+        std::vector<uint8_t> buffer(records.size() * record_bytes);
+        uint8_t* out = buffer.data();
+        for (const record& r : records)
+        {
+            *out++ = r.op;
+            *out++ = r.thread;
+            for (int i=0; i<4; i++) *out++ = uint8_t(r.id >> (8*i));
+            for (int i=0; i<4; i++) *out++ = uint8_t(r.size >> (8*i));
+        }
+        ok = ok && std::fwrite(buffer.data(), 1, buffer.size(), f) == buffer.size();
+        return std::fclose(f) == 0 && ok;
+    }
+
+    // Empty on error or version mismatch
+    inline std::vector<record> load(const char* path)
+    {
+        std::vector<record> records;
+        FILE* f = std::fopen(path, "rb");
+        if (!f) return records;
+        uint8_t header[16];
+        if (std::fread(header, 1, sizeof(header), f) != sizeof(header) || header[0] != 'A' || header[1] != 'T' || header[2] != 'R' || header[3] != 'C')
+        {
+            std::fclose(f);
+            return records;
+        }
+        uint32_t file_version = 0;
+        uint64_t count = 0;
+        for (int i=0; i<4; i++) file_version |= uint32_t(header[4+i]) << (8*i);
+        for (int i=0; i<8; i++) count |= uint64_t(header[8+i]) << (8*i);
+        if (file_version != version)
+        {
+            std::fclose(f);
+            return records;
+        }
+
+        std::vector<uint8_t> buffer(count * record_bytes);
+        if (std::fread(buffer.data(), 1, buffer.size(), f) == buffer.size())
+        {
+            records.resize(count);
+            const uint8_t* in = buffer.data();
+            for (record& r : records)
+            {
+                r.op = (record::kind)*in++;
+                r.thread = *in++;
+                r.id = 0;
+                r.size = 0;
+                for (int i=0; i<4; i++) r.id |= uint32_t(*in++) << (8*i);
+                for (int i=0; i<4; i++) r.size |= uint32_t(*in++) << (8*i);
+            }
+        }
+        std::fclose(f);
+        return records;
+    }
+
+    // Hook it into an allocator to capture a trace: on_allocate after every allocation, on_free before every free.
+    // Threads are numbered in the order they first show up. Safe to call from several threads.
+    class recorder
+    {
+    private:
+        std::mutex m_mutex;
+        std::vector<record> m_records;
+        std::unordered_map<const void*, uint32_t> m_live;
+        std::unordered_map<std::thread::id, uint8_t> m_threads;
+        uint32_t m_next_id = 0;
+
+        uint8_t thread_index()
+        {
+            auto it = m_threads.find(std::this_thread::get_id());
+            if (it != m_threads.end()) return it->second;
+            uint8_t index = (uint8_t)m_threads.size();
+            m_threads.emplace(std::this_thread::get_id(), index);
+            return index;
+        }
+
+    public:
+        void on_allocate(const void* p, size_t size)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            uint32_t id = m_next_id++;
+            m_live[p] = id;
+            m_records.push_back({record::allocate, thread_index(), id, (uint32_t)size});
+        }
+
+        void on_free(const void* p)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_live.find(p);
+            if (it == m_live.end()) return;
+            m_records.push_back({record::free, thread_index(), it->second, 0});
+            m_live.erase(it);
+        }
+
+        const std::vector<record>& records() const { return m_records; }
+
+        bool save(const char* path)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return trace::save(path, m_records);
+        }
+    };
+}
@@ -0,0 +1,484 @@
+// Replays a random malloc/free trace against owl::memory and the system malloc and shows the heap halfway through,
+// after comparing the startup cost of the default 2 GB arena with an eagerly zeroed buffer,
+// compares per-frame temporaries in owl::frame_memory with owl::memory and malloc,
+// runs a container-heavy workload on the default heap, owl::allocator and owl::memory_resource,
+// measures budgeted compaction steps of a fragmented arena, compares owl::small_memory size classes on small objects,
+// then scales owl::concurrent_memory and malloc across threads.
+// g++ -std=c++20 -O2 -DNDEBUG benchmark.cpp -o benchmark -pthread
+// Add -DOWL_MEMORY_DEBUG=1 to also check the guard bytes of small blocks freed from another thread.
+
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "concurrent_memory.h"
+#include "frame_memory.h"
+#include "memory_manager.h"
+#include "memory_resource.h"
+#include "small_memory.h"
+
+struct op
+{
+    bool    allocate;
+    size_t  size;       // allocation size
+    size_t  victim;     // random number picking the live allocation to free
+};
+
+// Mostly small requests with a tail of large ones, around 50k live allocations
+static std::vector<op> make_trace(size_t count, unsigned seed)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<op> trace(count);
+    size_t live = 0;
+    for (op& o : trace)
+    {
+        unsigned kind = rng()%100;
+        size_t size = kind < 70 ? 16 + rng()%240 : kind < 95 ? 256 + rng()%3840 : 4096 + rng()%61440;
+        o.allocate = live == 0 || (live < 50000 && rng()%2 == 0) || (live < 100000 && rng()%4 == 0);
+        o.size = size;
+        o.victim = rng();
+        live += o.allocate ? 1 : -1;
+    }
+    return trace;
+}
+
+template <class Alloc, class Free>
+static double replay(const std::vector<op>& trace, Alloc alloc, Free release)
+{
+    std::vector<char*> live;
+    live.reserve(trace.size());
+
+    auto startTime = std::chrono::steady_clock::now();
+    for (const op& o : trace)
+    {
+        if (o.allocate)
+        {
+            char* p = (char*)alloc(o.size);
+            p[0] = 1;
+            live.push_back(p);
+        }
+        else
+        {
+            size_t i = o.victim % live.size();
+            release(live[i]);
+            live[i] = live.back();
+            live.pop_back();
+        }
+    }
+    auto endTime = std::chrono::steady_clock::now();
+
+    for (char* p : live) release(p);
+    return std::chrono::duration<double, std::nano>(endTime - startTime).count() / trace.size();
+}
+
+// Stops halfway through the trace to print the heap telemetry, then frees everything
+static void heap_report(owl::memory& mem, const std::vector<op>& trace)
+{
+    std::vector<char*> live;
+    for (size_t i=0; i<trace.size()/2; i++)
+    {
+        const op& o = trace[i];
+        if (o.allocate)
+        {
+            live.push_back((char*)mem.allocate(o.size));
+            continue;
+        }
+        size_t k = o.victim % live.size();
+        mem.free_block(owl::memory::block_of(live[k]));
+        live[k] = live.back();
+        live.pop_back();
+    }
+
+    owl::memory::heap_stats s = mem.stats();
+    printf("heap: %zu KB live in %zu blocks, peak %zu KB, %zu free blocks, largest free %zu KB, external fragmentation %.4f\n",
+           s.live_bytes >> 10, s.used_blocks, s.peak_bytes >> 10, s.free_blocks, s.largest_free >> 10, s.external_fragmentation);
+    printf("free blocks by size:");
+    for (unsigned i=0; i<64; i++)
+    {
+        if (s.free_histogram[i] != 0) printf(" %zu..%zu:%zu", size_t(1) << i, (size_t(2) << i) - 1, s.free_histogram[i]);
+    }
+    printf("\n");
+
+    for (char* p : live) mem.free_block(owl::memory::block_of(p));
+}
+
+// Resident set size in MB, -1 where /proc is not available
+static double rss_mb()
+{
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return -1;
+    unsigned long pages = 0, resident = 0;
+    int n = fscanf(f, "%lu %lu", &pages, &resident);
+    fclose(f);
+    return n == 2 ? resident * 4096.0 / (1 << 20) : -1;
+}
+
+static double ms_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// What init() used to do: new char[2 GB] followed by memset, against the reserved arena
+static void startup()
+{
+    const size_t size = 2147483648;
+    const size_t blocks = 10000;
+
+    double base = rss_mb();
+    auto startTime = std::chrono::steady_clock::now();
+    char* eager = new char[size];
+    memset(eager, 0, size);
+    double eager_ms = ms_since(startTime);
+    double eager_rss = rss_mb() - base;
+    delete [] eager;
+
+    base = rss_mb();
+    startTime = std::chrono::steady_clock::now();
+    owl::memory mem;
+    mem.init(size);
+    double lazy_ms = ms_since(startTime);
+    double lazy_rss = rss_mb() - base;
+    for (size_t i=0; i<blocks; i++) memset(mem.allocate(64), 1, 64);
+    double used_rss = rss_mb() - base;
+
+    printf("startup: new+memset %.2f ms, %.1f MB resident\n", eager_ms, eager_rss);
+    printf("startup: reserved   %.2f ms, %.1f MB resident, %.1f MB after %zu blocks, %zu KB committed\n",
+           lazy_ms, lazy_rss, used_rss, blocks, mem.m_bytes_committed >> 10);
+    mem.terminate();
+}
+
+// Every frame allocates a burst of temporaries and drops all of them at the end, returns ns per temporary
+template <class Frame>
+static double run_frames(size_t frames, size_t per_frame, Frame frame)
+{
+    std::vector<size_t> sizes(per_frame);
+    std::mt19937 rng(5);
+    for (size_t& size : sizes) size = 16 + rng()%240;
+
+    auto startTime = std::chrono::steady_clock::now();
+    for (size_t f=0; f<frames; f++) frame(sizes);
+    auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(endTime - startTime).count() / (frames * per_frame);
+}
+
+static void frames()
+{
+    const size_t frames = 2000;
+    const size_t per_frame = 1000;
+    std::vector<char*> live(per_frame);
+
+    owl::memory mem;
+    mem.init(size_t(256) << 20);
+    owl::frame_memory frame;
+    frame.init(mem, size_t(1) << 20);
+    owl::frame_resource resource(frame);
+
+    double frame_ns = run_frames(frames, per_frame, [&](const std::vector<size_t>& sizes)
+    {
+        owl::frame_memory::scope scope(frame);
+        for (size_t size : sizes) ((char*)frame.allocate(size))[0] = 1;
+    });
+    double pmr_ns = run_frames(frames, per_frame, [&](const std::vector<size_t>& sizes)
+    {
+        owl::frame_memory::scope scope(frame);
+        std::pmr::vector<std::pmr::vector<char>> temporaries(&resource);
+        temporaries.reserve(sizes.size());
+        for (size_t size : sizes) temporaries.emplace_back(size, 1);
+    });
+    double owl_ns = run_frames(frames, per_frame, [&](const std::vector<size_t>& sizes)
+    {
+        for (size_t i=0; i<sizes.size(); i++) (live[i] = (char*)mem.allocate(sizes[i]))[0] = 1;
+        for (char* p : live) mem.free_block(owl::memory::block_of(p));
+    });
+    double malloc_ns = run_frames(frames, per_frame, [&](const std::vector<size_t>& sizes)
+    {
+        for (size_t i=0; i<sizes.size(); i++) (live[i] = (char*)malloc(sizes[i]))[0] = 1;
+        for (char* p : live) free(p);
+    });
+    printf("frames: owl::frame_memory %.1f ns/op, pmr vectors in a frame %.1f ns/op, owl::memory %.1f ns/op, malloc %.1f ns/op\n",
+           frame_ns, pmr_ns, owl_ns, malloc_ns);
+
+    frame.terminate();
+    mem.terminate();
+}
+
+// Each round fills an unordered_map of strings, grows a set of vectors one element at a time,
+// erases half of the map and drops everything. Returns microseconds per round.
+template <class Alloc>
+static double run_containers(size_t rounds, const Alloc& alloc)
+{
+    typedef std::allocator_traits<Alloc> traits;
+    typedef std::basic_string<char, std::char_traits<char>, typename traits::template rebind_alloc<char>> string;
+    typedef std::vector<int, typename traits::template rebind_alloc<int>> vector;
+    typedef std::unordered_map<int, string, std::hash<int>, std::equal_to<int>, typename traits::template rebind_alloc<std::pair<const int, string>>> map;
+
+    const char* text = "a value long enough to leave the small string buffer";
+    auto startTime = std::chrono::steady_clock::now();
+    for (size_t r=0; r<rounds; r++)
+    {
+        map entries(0, std::hash<int>(), std::equal_to<int>(), alloc);
+        for (int i=0; i<2000; i++) entries.emplace(i, string(text, alloc));
+
+        std::vector<vector> vectors;
+        vectors.reserve(200);
+        for (int v=0; v<200; v++)
+        {
+            vectors.emplace_back(alloc);
+            for (int i=0; i<100; i++) vectors.back().push_back(i);
+        }
+
+        for (int i=0; i<2000; i+=2) entries.erase(i);
+        for (auto& entry : entries) entry.second += "!";
+    }
+    auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(endTime - startTime).count() / rounds;
+}
+
+static void containers()
+{
+    const size_t rounds = 200;
+
+    owl::memory mem;
+    mem.init(size_t(256) << 20);
+    owl::memory_resource resource(mem);
+
+    double heap_us = run_containers(rounds, std::allocator<char>());
+    double owl_us = run_containers(rounds, owl::allocator<char>(mem));
+    double pmr_us = run_containers(rounds, std::pmr::polymorphic_allocator<char>(&resource));
+    printf("containers: std::allocator %.1f us/round, owl::allocator %.1f us/round, owl::memory_resource %.1f us/round\n",
+           heap_us, owl_us, pmr_us);
+
+    // Sizes near SIZE_MAX must fail instead of wrapping around to a small block
+    bool rejected = mem.allocate(SIZE_MAX - 3) == NULL && mem.allocate_aligned(SIZE_MAX - 20, 64) == NULL;
+    try
+    {
+        (void)resource.allocate(SIZE_MAX - 20, 64);
+        rejected = false;
+    }
+    catch (const std::bad_alloc&)
+    {
+    }
+    printf("containers: requests near SIZE_MAX %s\n", rejected ? "rejected" : "wrapped around");
+
+    mem.terminate();
+}
+
+// Every movable block starts with its index in the table, so the relocation callback can fix the table up
+static void relocate_entry(void*, void* to, size_t, void* user)
+{
+    std::vector<char*>& table = *(std::vector<char*>*)user;
+    table[*(size_t*)to] = (char*)to;
+}
+
+// Frees every other block of a full arena, then compacts it in 100 us steps
+static void compaction()
+{
+    const size_t blocks = 200000;
+
+    owl::memory mem;
+    mem.init(size_t(64) << 20);
+    std::vector<char*> table(blocks);
+    mem.set_relocator(relocate_entry, &table);
+
+    std::mt19937 rng(11);
+    size_t freed = 0;
+    for (size_t i=0; i<blocks; i++)
+    {
+        size_t size = 16 + rng()%496;
+        table[i] = (char*)mem.allocate_movable(size);
+        *(size_t*)table[i] = i;
+    }
+    for (size_t i=0; i<blocks; i+=2)
+    {
+        freed += owl::memory::block_of(table[i])->bytes();
+        mem.free_block(owl::memory::block_of(table[i]));
+        table[i] = NULL;
+    }
+
+    void* before = mem.allocate(freed/2);
+    if (before != NULL) mem.free_block(owl::memory::block_of(before));
+
+    std::vector<double> steps;
+    bool done = false;
+    while (!done)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        done = mem.compact(100);
+        steps.push_back(ms_since(startTime) * 1000);
+    }
+    std::sort(steps.begin(), steps.end());
+    void* after = mem.allocate(freed/2);
+
+    size_t intact = 0;
+    for (size_t i=1; i<blocks; i+=2) intact += *(size_t*)table[i] == i;
+    printf("compaction: %zu steps, p50 %.1f us, max %.1f us, %zu/%zu blocks tracked, %zu KB block fits before %s, after %s\n",
+           steps.size(), steps[steps.size()/2], steps.back(), intact, blocks/2, freed/2 >> 10,
+           before != NULL ? "yes" : "no", after != NULL ? "yes" : "no");
+    mem.terminate();
+}
+
+// Footprint of many 24 byte objects, then a churn of mostly small mixed sizes with sized frees
+static void small_objects()
+{
+    const size_t objects = 1000000;
+    const size_t operations = 2000000;
+
+    owl::memory mem;
+    mem.init(size_t(1) << 30);
+    owl::small_memory small;
+    small.init(mem);
+
+    std::vector<char*> live(objects);
+    for (char*& p : live) p = (char*)mem.allocate(24);
+    owl::memory::heap_stats s = mem.stats();
+    double owl_bytes = double(s.live_bytes + s.used_blocks * sizeof(owl::memory::block)) / objects;
+    for (char* p : live) mem.free_block(owl::memory::block_of(p));
+    for (char*& p : live) p = (char*)small.allocate(24);
+    double small_bytes = double(small.slabs_in_use() * owl::small_memory::slab_size) / objects;
+    for (char* p : live) small.deallocate(p, 24);
+
+    std::mt19937 rng(17);
+    std::vector<size_t> sizes(operations);
+    for (size_t& size : sizes) size = rng()%100 < 90 ? 8 + rng()%249 : 257 + rng()%3840;
+
+    // allocates the first half of the sizes, then frees one live object and allocates the next size per step
+    auto churn = [&](auto alloc, auto release)
+    {
+        std::vector<std::pair<char*, size_t>> held;
+        held.reserve(operations/2);
+        std::mt19937 pick(3);
+        auto startTime = std::chrono::steady_clock::now();
+        for (size_t i=0; i<operations/2; i++) held.push_back({(char*)alloc(sizes[i]), sizes[i]});
+        for (size_t i=operations/2; i<operations; i++)
+        {
+            auto& victim = held[pick() % held.size()];
+            release(victim.first, victim.second);
+            victim = {(char*)alloc(sizes[i]), sizes[i]};
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count() / (operations * 1.5);
+        for (auto& h : held) release(h.first, h.second);
+        return ns;
+    };
+
+    double small_ns = churn([&](size_t size) { return small.allocate(size); }, [&](char* p, size_t size) { small.deallocate(p, size); });
+    double owl_ns = churn([&](size_t size) { return mem.allocate(size); }, [&](char* p, size_t) { mem.free_block(owl::memory::block_of(p)); });
+    double malloc_ns = churn([](size_t size) { return malloc(size); }, [](char* p, size_t) { free(p); });
+
+    printf("small objects: 24 byte object takes %.1f bytes in owl::small_memory, %.1f in owl::memory\n", small_bytes, owl_bytes);
+    printf("small objects: owl::small_memory %.1f ns/op, owl::memory %.1f ns/op, malloc %.1f ns/op\n", small_ns, owl_ns, malloc_ns);
+
+    small.terminate();
+    mem.terminate();
+}
+
+// Every round each thread allocates a batch of mixed sizes, frees half of it and frees the other half of its
+// neighbour's batch, so half of all frees cross threads. Returns ns per allocate+free pair.
+template <class Alloc, class Free>
+static double run_threads(unsigned threads, size_t rounds, size_t batch, Alloc alloc, Free release)
+{
+    std::vector<std::vector<char*>> batches(threads, std::vector<char*>(batch));
+    std::barrier sync(threads);
+
+    auto worker = [&](unsigned t)
+    {
+        std::vector<char*>& mine = batches[t];
+        std::vector<char*>& theirs = batches[(t+1)%threads];
+        std::mt19937 rng(t);
+        for (size_t r=0; r<rounds; r++)
+        {
+            for (size_t i=0; i<batch; i++)
+            {
+                mine[i] = (char*)alloc(16 + rng()%496);
+                mine[i][0] = 1;
+            }
+            for (size_t i=0; i<batch; i+=2) release(mine[i]);
+            sync.arrive_and_wait();
+            for (size_t i=1; i<batch; i+=2) release(theirs[i]);
+            sync.arrive_and_wait();
+        }
+    };
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned t=0; t<threads; t++) pool.emplace_back(worker, t);
+    for (std::thread& th : pool) th.join();
+    auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(endTime - startTime).count() / (double(threads) * rounds * batch);
+}
+
+static void scaling()
+{
+    unsigned max_threads = std::max(4u, std::thread::hardware_concurrency());
+    const size_t rounds = 200;
+    const size_t batch = 2000;
+
+    for (unsigned threads=1; threads<=max_threads; threads*=2)
+    {
+        owl::concurrent_memory mem;
+        mem.init(threads, size_t(64) << 20);
+        double owl_ns = run_threads(threads, rounds, batch,
+            [&](size_t size) { return mem.allocate(size); },
+            [&](char* p) { mem.deallocate(p); });
+        double malloc_ns = run_threads(threads, rounds, batch,
+            [](size_t size) { return malloc(size); },
+            [](char* p) { free(p); });
+        printf("threads %2u: owl::concurrent_memory %.1f ns/op, malloc %.1f ns/op\n", threads, owl_ns, malloc_ns);
+    }
+}
+
+#if OWL_MEMORY_DEBUG
+// Blocks smaller than a pointer freed from another thread hold the remote list link in front of their guards
+static void remote_small_frees()
+{
+    owl::concurrent_memory mem;
+    mem.init(2, size_t(16) << 20);
+    std::vector<void*> blocks;
+    for (size_t size=1; size<=16; size++) blocks.push_back(mem.allocate(size));
+    std::thread([&] { for (void* p : blocks) mem.deallocate(p); }).join();
+    mem.deallocate(mem.allocate(4));    // drains the remote list, an overwritten guard aborts here
+    printf("debug: small blocks freed from another thread keep their guards\n");
+}
+#endif
+
+int main()
+{
+    startup();
+
+    const size_t operations = 1000000;
+    std::vector<op> trace = make_trace(operations, 2024);
+
+    owl::memory mem;
+    mem.init(size_t(1) << 30);
+
+    for (int run=0; run<3; run++)
+    {
+        double owl_ns = replay(trace,
+            [&](size_t size) { return mem.allocate(size); },
+            [&](char* p) { mem.free_block((owl::memory::block*)(p - sizeof(owl::memory::block))); });
+        double malloc_ns = replay(trace,
+            [](size_t size) { return malloc(size); },
+            [](char* p) { free(p); });
+
+        printf("run %d: owl::memory %.1f ns/op, malloc %.1f ns/op\n", run, owl_ns, malloc_ns);
+    }
+    heap_report(mem, trace);
+
+    mem.terminate();
+
+    frames();
+    containers();
+    compaction();
+    small_objects();
+    scaling();
+#if OWL_MEMORY_DEBUG
+    remote_small_frees();
+#endif
+    return 0;
+}
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "memory_manager.h"
+
+namespace owl {
+    // Multi-arena front end for owl::memory that can be used from many threads at once.
+    // One address space reservation is cut into equal slices and every thread that allocates claims a slice
+    // managed by its own owl::memory, so allocating and freeing on the owning thread take no lock. The owner
+    // of a block is found from its address: the slice index is the offset from the reservation divided by the
+    // slice size.
+    // free_block on an owl::memory is single threaded, so a block freed by another thread is linked through its
+    // own payload onto the owner's remote list instead. Other threads only push to that list and the owner takes
+    // it whole with one exchange before allocating, so no pop ever races a push.
+    // When a thread exits it drains its remote list and hands its arena back, with the blocks still live in it,
+    // and the next thread that needs an arena takes it over. Only threads running at the same time need an arena
+    // each.
+    class concurrent_memory
+    {
+        public:
+            concurrent_memory()
+            {
+                m_base = NULL;
+                m_arenas = NULL;
+                m_arena_count = 0;
+                m_arena_size = 0;
+            }
+
+            concurrent_memory(const concurrent_memory&) = delete;
+            concurrent_memory& operator=(const concurrent_memory&) = delete;
+
+            ~concurrent_memory()
+            {
+                terminate();
+            }
+
+            // Reserves _arenas slices of _arena_size bytes, at most _arenas threads can allocate at the same time
+            void init (size_t _arenas, size_t _arena_size=size_t(256) << 20, size_t _release_threshold=0)
+            {
+                if (m_base!=NULL) return;
+
+                m_arena_count = _arenas;
+                m_arena_size = (_arena_size + memory::commit_granularity - 1) / memory::commit_granularity * memory::commit_granularity;
+                size_t total = m_arena_count * m_arena_size;
+#if defined(__linux__)
+                void* p = mmap(NULL, total, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+                if (p == MAP_FAILED) throw std::bad_alloc();
+                m_base = (char*)p;
+#else
+                m_base = new char[total];
+#endif
+                m_arenas = new arena[m_arena_count];
+                for (size_t i=0; i<m_arena_count; i++)
+                {
+                    m_arenas[i].mem.init(m_base + i*m_arena_size, m_arena_size, _release_threshold);
+                }
+                m_claimed = 0;
+                m_vacant.clear();
+                m_id = next_id();   // threads that used an earlier init no longer find their arenas
+
+                registry& r = live_allocators();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                r.allocators[m_id] = this;
+            }
+
+            // No thread may use the allocator while it is terminated
+            void terminate()
+            {
+                if (m_base == NULL) return;
+                {
+                    // after this no exiting thread touches the arenas
+                    registry& r = live_allocators();
+                    std::lock_guard<std::mutex> lock(r.mutex);
+                    r.allocators.erase(m_id);
+                }
+                for (size_t i=0; i<m_arena_count; i++) m_arenas[i].mem.terminate();
+                delete [] m_arenas;
+#if defined(__linux__)
+                munmap(m_base, m_arena_count * m_arena_size);
+#else
+                delete [] m_base;
+#endif
+                m_base = NULL;
+                m_arenas = NULL;
+            }
+
+            // Returns NULL when the calling thread's arena is full or every arena is taken by a running thread
+            void* allocate(size_t size)
+            {
+                arena* a = local_arena();
+                if (a == NULL) return NULL;
+                if (a->remote_free.load(std::memory_order_relaxed) != NULL) drain(a);
+                void* p = a->mem.allocate(size);
+                if (p == NULL && a->remote_free.load(std::memory_order_relaxed) != NULL)
+                {
+                    drain(a);
+                    p = a->mem.allocate(size);
+                }
+                return p;
+            }
+
+            // Can be called from any thread
+            void deallocate(void* _ptr)
+            {
+                arena* owner = &m_arenas[((char*)_ptr - m_base) / m_arena_size];
+                if (owned_arena() == owner)
+                {
+                    owner->mem.free_block(memory::block_of(_ptr));
+                    return;
+                }
+
+                remote_node* node = (remote_node*)_ptr;
+                remote_node* head = owner->remote_free.load(std::memory_order_relaxed);
+                do
+                {
+                    node->next = head;
+                }
+                while (!owner->remote_free.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+            }
+
+            // Arenas owned by running threads
+            size_t arenas_in_use() const
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_claimed - m_vacant.size();
+            }
+
+            size_t arena_size() const { return m_arena_size; }
+
+        private:
+            // Stored in the payload of a block waiting in a remote list
+            struct remote_node
+            {
+                remote_node* next;
+            };
+
+            struct alignas(64) arena
+            {
+                memory          mem;
+                alignas(64) std::atomic<remote_node*> remote_free{NULL};    // pushed by other threads
+            };
+
+            // Arenas the thread owns, by allocator id (a new one on every init). Scanned without a lock: a thread
+            // rarely works with more than a couple of allocators, and switching between them stays cheap.
+            struct thread_arenas
+            {
+                std::vector<std::pair<uint64_t, arena*>> owned;
+
+                // Hands the arenas back to the allocators still alive
+                ~thread_arenas()
+                {
+                    registry& r = live_allocators();
+                    std::lock_guard<std::mutex> lock(r.mutex);
+                    for (const std::pair<uint64_t, arena*>& entry : owned)
+                    {
+                        auto it = r.allocators.find(entry.first);
+                        if (it != r.allocators.end()) it->second->vacate(entry.second);
+                    }
+                }
+            };
+
+            // Initialised allocators by id, so an exiting thread never touches one that was terminated
+            struct registry
+            {
+                std::mutex mutex;
+                std::unordered_map<uint64_t, concurrent_memory*> allocators;
+            };
+
+            static registry& live_allocators()
+            {
+                static registry r;
+                return r;
+            }
+
+            static uint64_t next_id()
+            {
+                static std::atomic<uint64_t> id{0};
+                return ++id;
+            }
+
+            static thread_arenas& local()
+            {
+                static thread_local thread_arenas t;
+                return t;
+            }
+
+            uint64_t            m_id = next_id();
+            char*               m_base;
+            arena*              m_arenas;
+            size_t              m_arena_count;
+            size_t              m_arena_size;
+            size_t              m_claimed = 0;  // arenas ever handed out, they are taken in order
+            std::vector<arena*> m_vacant;       // handed back by threads that exited
+            mutable std::mutex  m_mutex;        // guards m_claimed and m_vacant, only taken when a thread starts or exits
+
+            // The calling thread's arena in this allocator, NULL if it has none yet
+            arena* owned_arena()
+            {
+                for (const std::pair<uint64_t, arena*>& entry : local().owned)
+                {
+                    if (entry.first == m_id) return entry.second;
+                }
+                return NULL;
+            }
+
+            arena* local_arena()
+            {
+                arena* a = owned_arena();
+                return a != NULL ? a : claim_arena();
+            }
+
+            arena* claim_arena()
+            {
+                std::vector<std::pair<uint64_t, arena*>>& owned = local().owned;
+                {
+                    // forget allocators terminated or initialised again since
+                    registry& r = live_allocators();
+                    std::lock_guard<std::mutex> lock(r.mutex);
+                    owned.erase(std::remove_if(owned.begin(), owned.end(), [&](const std::pair<uint64_t, arena*>& entry) { return r.allocators.count(entry.first) == 0; }), owned.end());
+                }
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                arena* a = NULL;
+                if (!m_vacant.empty())
+                {
+                    // the remote frees that reached it after its thread left are drained by the first allocate
+                    a = m_vacant.back();
+                    m_vacant.pop_back();
+                }
+                else
+                {
+                    if (m_claimed == m_arena_count) return NULL;
+                    a = &m_arenas[m_claimed++];
+                }
+                owned.emplace_back(m_id, a);
+                return a;
+            }
+
+            // Called on the exiting owner thread
+            void vacate(arena* a)
+            {
+                drain(a);
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_vacant.push_back(a);
+            }
+
+            // Gives back everything other threads freed, in one exchange
+            void drain(arena* a)
+            {
+                remote_node* node = a->remote_free.exchange(NULL, std::memory_order_acquire);
+                while (node != NULL)
+                {
+                    remote_node* next = node->next;
+                    a->mem.free_block(memory::block_of(node));
+                    node = next;
+                }
+            }
+    };
+}
+
+inline void * operator new (std::size_t size, owl::concurrent_memory& mem)
+{
+    void* p = mem.allocate(size);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+// Called when a constructor throws inside new (mem) T
+inline void operator delete (void* p, owl::concurrent_memory& mem)
+{
+    mem.deallocate(p);
+}
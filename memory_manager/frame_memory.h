@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include "memory_manager.h"
+
+namespace owl {
+    // Bump allocator for temporaries that die together, nested in one block of an owl::memory.
+    // Allocating moves a pointer, nothing is freed one by one: mark() remembers the top and rewind() pops
+    // everything allocated after it, reset() empties the frame. Objects are not destroyed on rewind,
+    // only put trivially destructible types or types whose destructor does not matter in a frame.
+    class frame_memory
+    {
+        public:
+            typedef size_t marker;
+
+            // Pops everything allocated in the frame during its lifetime, scopes nest like the stack
+            class scope
+            {
+                public:
+                    explicit scope(frame_memory& _frame) : m_frame(_frame), m_marker(_frame.mark()) {}
+                    ~scope() { m_frame.rewind(m_marker); }
+
+                    scope(const scope&) = delete;
+                    scope& operator=(const scope&) = delete;
+
+                private:
+                    frame_memory&   m_frame;
+                    marker          m_marker;
+            };
+
+            frame_memory()
+            {
+                m_parent = NULL;
+                m_begin = NULL;
+                m_top = 0;
+                m_capacity = 0;
+                m_high_water = 0;
+            }
+
+            frame_memory(const frame_memory&) = delete;
+            frame_memory& operator=(const frame_memory&) = delete;
+
+            ~frame_memory()
+            {
+                terminate();
+            }
+
+            // Takes one block of _capacity bytes from _parent, throws std::bad_alloc when it does not fit
+            void init (memory& _parent, size_t _capacity)
+            {
+                if (m_begin!=NULL) return;
+
+                m_begin = (char*)_parent.allocate(_capacity);
+                if (m_begin == NULL) throw std::bad_alloc();
+                m_parent = &_parent;
+                m_capacity = _capacity;
+                m_top = 0;
+                m_high_water = 0;
+            }
+
+            // Gives the block back to the parent arena
+            void terminate()
+            {
+                if (m_begin == NULL) return;
+                m_parent->free_block(memory::block_of(m_begin));
+                m_begin = NULL;
+                m_parent = NULL;
+                m_top = 0;
+                m_capacity = 0;
+            }
+
+            // Returns NULL when the frame is full, _align must be a power of two
+            void* allocate(size_t size, size_t _align=alignof(std::max_align_t))
+            {
+                uintptr_t base = (uintptr_t)m_begin;
+                size_t start = ((base + m_top + _align - 1) & ~(uintptr_t)(_align - 1)) - base;
+                if (start + size > m_capacity) return NULL;
+                m_top = start + size;
+                if (m_top > m_high_water) m_high_water = m_top;
+                return m_begin + start;
+            }
+
+            template <class T>
+            T* allocate ()
+            {
+                void* p = allocate(sizeof(T), alignof(T));
+                if (p == NULL) throw std::bad_alloc();
+                return new (p) T;
+            }
+
+            marker mark() const { return m_top; }
+
+            void rewind(marker _marker)
+            {
+                assert(_marker <= m_top && "owl::frame_memory: rewind past the top");
+                m_top = _marker;
+            }
+
+            void reset() { m_top = 0; }
+
+            size_t used() const { return m_top; }
+            size_t capacity() const { return m_capacity; }
+            size_t high_water() const { return m_high_water; }
+
+        private:
+            memory*     m_parent;
+            char*       m_begin;
+            size_t      m_top;
+            size_t      m_capacity;
+            size_t      m_high_water;
+    };
+
+    // Lets pmr containers allocate from a frame. Deallocation is a no-op, memory comes back with the
+    // frame's rewind() or reset(), so the containers must not outlive the scope they were filled in.
+    class frame_resource : public std::pmr::memory_resource
+    {
+        public:
+            explicit frame_resource(frame_memory& _frame) : m_frame(_frame) {}
+
+            frame_memory& frame() const { return m_frame; }
+
+        private:
+            frame_memory&   m_frame;
+
+            void* do_allocate(size_t bytes, size_t align) override
+            {
+                void* p = m_frame.allocate(bytes, align);
+                if (p == NULL) throw std::bad_alloc();
+                return p;
+            }
+
+            void do_deallocate(void*, size_t, size_t) override {}
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+            {
+                return this == &other;
+            }
+    };
+}
@@ -0,0 +1,669 @@
+/*
+OwlSL (Owl Script Language)
+
+Copyright (c) 2013-2014 Damian Reloaded <>
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#pragma once
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+#include <chrono>
+#include <new>
+
+// Define OWL_MEMORY_DEBUG=1 to put guard bytes behind every allocation, check them on free, fill freed memory
+// and catch double frees of blocks that were already merged. With the default of 0 none of it is compiled in.
+#ifndef OWL_MEMORY_DEBUG
+#define OWL_MEMORY_DEBUG 0
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace owl {
+    // Two-level segregated fit (TLSF) allocator over one buffer.
+    // Free blocks are kept in bins indexed by (first level = power of two, second level = 16 linear steps)
+    // with a bitmap per level, so finding a big enough block, inserting and removing are all O(1).
+    // Free blocks end with a footer holding their header offset and the block after a free block has
+    // prev_free_bit set, so free_block() reaches both physical neighbors and merges them in O(1).
+    // Two free blocks are never left adjacent.
+    // On Linux the buffer is only reserved with mmap(PROT_NONE) and committed in commit_granularity steps as the
+    // highest allocated address grows, so a large reserve costs nothing until it is used.
+    // Blocks from allocate_movable() may be slid toward the start of the buffer by compact(), which reports
+    // every move to the registered relocation callback.
+    class memory
+    {
+        public:
+            struct block
+            {
+                block() : pos(0), size(0){}
+                size_t pos;     // offset of the payload in m_buffer
+                size_t size;    // payload bytes, the three lowest bits hold free_bit, prev_free_bit and movable_bit
+
+                size_t bytes() const { return size & ~flag_bits; }
+                bool   is_free() const { return (size & free_bit) != 0; }
+                bool   is_prev_free() const { return (size & prev_free_bit) != 0; }
+                bool   is_movable() const { return (size & movable_bit) != 0; }
+            };
+
+            static const size_t alignment   = 16;
+            static const size_t free_bit    = 1;
+            static const size_t prev_free_bit = 2;                // the physically previous block is free
+            static const size_t movable_bit = 4;                  // compact() may move the block
+            static const size_t flag_bits   = free_bit | prev_free_bit | movable_bit;
+            static const size_t min_block   = 4*sizeof(size_t);   // room for the free list links and the footer
+            static const size_t none        = SIZE_MAX;
+            static const size_t commit_granularity = size_t(1) << 20;
+
+            static const unsigned sl_log2   = 4;
+            static const unsigned sl_count  = 1u << sl_log2;
+            static const unsigned fl_shift  = sl_log2 + 4;        // sizes below 256 bytes use first level 0
+            static const unsigned fl_count  = 64 - fl_shift + 1;
+
+            static_assert(sizeof(block) % alignment == 0, "block header must keep payloads aligned");
+
+            struct heap_stats
+            {
+                size_t live_bytes;              // payload bytes of used blocks
+                size_t peak_bytes;              // highest live_bytes since init
+                size_t used_blocks;
+                size_t free_bytes;              // including the untouched tail of the buffer
+                size_t free_blocks;
+                size_t largest_free;
+                double external_fragmentation;  // 1 - largest_free / free_bytes
+                size_t free_histogram[64];      // free blocks by floor(log2(bytes))
+            };
+
+#if OWL_MEMORY_DEBUG
+            static const size_t guard_size  = 16;                   // at least this many guard bytes per block
+            static const unsigned char guard_fill = 0xFD;
+            static const unsigned char freed_fill = 0xDD;
+#endif
+
+            // Called by compact() after a movable block was copied from _from to _to, must not use the arena
+            typedef void (*relocate_fn)(void* _from, void* _to, size_t _bytes, void* _user);
+
+            memory()
+            {
+                m_buffer = NULL;
+                m_owns_buffer = false;
+                m_relocate = NULL;
+                m_relocate_user = NULL;
+            }
+
+            // _buffersize is the address space reserved up front.
+            // Free blocks of at least _release_threshold bytes hand their pages back with MADV_FREE, 0 keeps them.
+            void init (const size_t& _buffersize=2147483648, size_t _release_threshold=0) //4294967296
+            {
+                if (m_buffer!=NULL) return;
+
+                size_t size = _buffersize / alignment * alignment;
+#if defined(__linux__)
+                void* p = mmap(NULL, size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+                if (p == MAP_FAILED) throw std::bad_alloc();
+#else
+                char* p = new char[size];
+#endif
+                try
+                {
+                    init((char*)p, size, _release_threshold);
+                }
+                catch (...)
+                {
+#if defined(__linux__)
+                    munmap(p, size);
+#else
+                    delete [] p;
+#endif
+                    throw;
+                }
+                m_owns_buffer = true;
+            }
+
+            // Manages a region owned by the caller, terminate() leaves it alone.
+            // On Linux the region must be a page aligned part of a PROT_NONE reservation, elsewhere it must be accessible.
+            void init (char* _buffer, size_t _buffersize, size_t _release_threshold=0)
+            {
+                if (m_buffer!=NULL) return;
+
+                m_bytes_allocated = 0;
+                m_bytes_peak = 0;
+                m_buffer = _buffer;
+                m_buffer_size = _buffersize / alignment * alignment;
+                m_release_threshold = _release_threshold;
+                m_owns_buffer = false;
+                m_compact_cursor = 0;
+#if defined(__linux__)
+                m_bytes_committed = 0;
+                if (!commit(sizeof(block) + min_block))
+                {
+                    m_buffer = NULL;
+                    throw std::bad_alloc();
+                }
+#else
+                m_bytes_committed = m_buffer_size;
+#endif
+
+                m_fl_bitmap = 0;
+                for (unsigned fl=0; fl<fl_count; fl++)
+                {
+                    m_sl_bitmap[fl] = 0;
+                    for (unsigned sl=0; sl<sl_count; sl++) m_heads[fl][sl] = none;
+                }
+
+                block* b = (block*)&m_buffer[0];
+
+                b->size = m_buffer_size-sizeof(block);
+                b->pos  = 0+sizeof(block);
+                insert_free(b);
+            }
+
+            void terminate()
+            {
+                if (m_owns_buffer)
+                {
+#if defined(__linux__)
+                    munmap(m_buffer, m_buffer_size);
+#else
+                    delete [] m_buffer;
+#endif
+                }
+                m_buffer = NULL;
+                m_owns_buffer = false;
+            }
+
+            // Returns NULL when no free block is big enough
+            void* allocate(std::size_t size)
+            {
+                // checked before the guard and the rounding are added, which would wrap around near SIZE_MAX
+                if (size > m_buffer_size) return NULL;
+#if OWL_MEMORY_DEBUG
+                // concurrent_memory links blocks freed by other threads through their first word, the guards start after it
+                size_t requested = size < sizeof(void*) ? sizeof(void*) : size;
+                size = requested + guard_size + sizeof(size_t);
+#endif
+                size = adjust(size);
+
+                unsigned fl, sl;
+                mapping_search(size, fl, sl);
+                block* taken = find_suitable(fl, sl);
+                // the rounded up bin may be empty while the request's own bin holds a block that fits
+                if (taken == NULL) taken = search_bin(size);
+                if (taken == NULL) return NULL;
+
+                // if the chunk is bigger than size, cut it to size and create a new free chunk with the rest
+                bool split = taken->bytes() >= size+sizeof(block)+min_block;
+                // only the last block can reach past the committed pages, the split writes the next header and links
+                if (!commit(split ? taken->pos + size + sizeof(block) + sizeof(links) : taken->pos + taken->bytes())) return NULL;
+                remove_free(taken);
+
+                if (split)
+                {
+                    size_t newblockpos = taken->pos+size;
+                    block* remaining = (block*)&m_buffer[newblockpos];
+                    remaining->pos = newblockpos+sizeof(block);
+                    remaining->size = taken->bytes() - (size+sizeof(block)) ;
+                    taken->size = size | (taken->size & prev_free_bit);
+                    insert_free(remaining);
+                }
+                else
+                {
+                    block* next = physical_next(taken);
+                    if (next != NULL) next->size &= ~prev_free_bit;
+                }
+
+                // allocate memory block
+                m_bytes_allocated += taken->bytes();
+                if (m_bytes_allocated > m_bytes_peak) m_bytes_peak = m_bytes_allocated;
+#if OWL_MEMORY_DEBUG
+                set_guard(taken, requested);
+#endif
+                return &m_buffer[taken->pos];
+            }
+
+            // Same as allocate() but the block may be moved by compact(), the owner must be reachable from the
+            // relocation callback to fix its pointers
+            void* allocate_movable(std::size_t size)
+            {
+                void* p = allocate(size);
+                if (p != NULL) block_of(p)->size |= movable_bit;
+                return p;
+            }
+
+            void set_relocator(relocate_fn _relocate, void* _user)
+            {
+                m_relocate = _relocate;
+                m_relocate_user = _user;
+            }
+
+            // Slides movable blocks down over the free block in front of them so holes bubble toward the end
+            // of the buffer and merge. Resumes where the last call stopped and returns after about _budget_us
+            // microseconds, true once a pass over the whole buffer has finished.
+            bool compact(double _budget_us=100)
+            {
+                std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::micro>(_budget_us));
+                unsigned steps = 0;
+                block* b = (block*)&m_buffer[m_compact_cursor];
+                while (b != NULL)
+                {
+                    block* next = physical_next(b);
+                    bool moved = b->is_free() && next != NULL && next->is_movable();
+                    b = moved ? slide(b, next) : next;
+                    // the clock is read after every move and every 16 blocks skipped
+                    if ((moved || (++steps & 15) == 0) && b != NULL && std::chrono::steady_clock::now() >= deadline)
+                    {
+                        m_compact_cursor = offset(b);
+                        return false;
+                    }
+                }
+                m_compact_cursor = 0;
+                return true;
+            }
+
+            // For alignments above `alignment`: over-allocates and keeps the payload address right before the
+            // returned pointer. Returns NULL when no block fits, free it with free_aligned and the same _align.
+            void* allocate_aligned(std::size_t size, std::size_t _align)
+            {
+                if (_align <= alignment) return allocate(size);
+                if (size > m_buffer_size || _align > m_buffer_size) return NULL;
+                char* p = (char*)allocate(size + _align);
+                if (p == NULL) return NULL;
+                char* aligned = (char*)(((uintptr_t)p + sizeof(void*) + _align - 1) & ~(uintptr_t)(_align - 1));
+                ((char**)aligned)[-1] = p;
+                return aligned;
+            }
+
+            void free_aligned(void* _ptr, std::size_t _align)
+            {
+                if (_align > alignment) _ptr = ((char**)_ptr)[-1];
+                free_block(block_of(_ptr));
+            }
+
+            template <class T>
+            T* allocate ()
+            {
+                return new (*this) T;
+            }
+
+            template <class T>
+            void deallocate(T* _ptr)
+            {
+                _ptr->~T();
+                block* b = (block*)(((char*)_ptr)-sizeof(block));
+                free_block(b);
+                return;
+            }
+
+            // Header of the block whose payload starts at _ptr
+            static block* block_of(void* _ptr)
+            {
+                return (block*)(((char*)_ptr)-sizeof(block));
+            }
+
+            void free_block (block* _block)
+            {
+#if OWL_MEMORY_DEBUG
+                check_block(_block);
+                memset(&m_buffer[_block->pos], freed_fill, _block->bytes());
+#endif
+                assert(!_block->is_free() && "owl::memory: double free");
+                _block->size &= ~movable_bit;
+                m_bytes_allocated -= _block->bytes();
+                coalesce(_block);
+            }
+
+            // Calls _visit(void* payload, size_t bytes, bool free) for every block in address order.
+            // The arena must not change during the walk.
+            template <class Visit>
+            void walk(Visit _visit)
+            {
+                for (block* b = (block*)&m_buffer[0]; b != NULL; b = physical_next(b))
+                {
+                    _visit((void*)&m_buffer[b->pos], b->bytes(), b->is_free());
+                }
+            }
+
+            // Walks the whole heap
+            heap_stats stats()
+            {
+                heap_stats s;
+                memset(&s, 0, sizeof(s));
+                s.live_bytes = m_bytes_allocated;
+                s.peak_bytes = m_bytes_peak;
+                walk([&s](void*, size_t bytes, bool free)
+                {
+                    if (!free)
+                    {
+                        s.used_blocks++;
+                        return;
+                    }
+                    s.free_blocks++;
+                    s.free_bytes += bytes;
+                    if (bytes > s.largest_free) s.largest_free = bytes;
+                    s.free_histogram[msb(bytes)]++;
+                });
+                s.external_fragmentation = s.free_bytes != 0 ? 1.0 - (double)s.largest_free / (double)s.free_bytes : 0.0;
+                return s;
+            }
+
+            // Only scans the highest non-empty bin
+            size_t largest_free_block()
+            {
+                if (m_fl_bitmap == 0) return 0;
+                unsigned fl = msb(m_fl_bitmap);
+                unsigned sl = 31 - (unsigned)__builtin_clz(m_sl_bitmap[fl]);
+                size_t largest = 0;
+                for (block* b = header(m_heads[fl][sl]); b != NULL; b = header(links_of(b)->next))
+                {
+                    if (b->bytes() > largest) largest = b->bytes();
+                }
+                return largest;
+            }
+
+            // Walks the buffer once and merges every run of adjacent free blocks.
+            // free_block() already coalesces, so this only finds work if blocks were freed behind its back.
+            void defrag()
+            {
+                block* b = (block*)&m_buffer[0];
+                while (b != NULL)
+                {
+                    block* next = physical_next(b);
+                    if (b->is_free() && next != NULL && next->is_free())
+                    {
+                        remove_free(b);
+                        remove_free(next);
+                        b->size = (b->bytes() + sizeof(block) + next->bytes()) | (b->size & prev_free_bit);
+                        if (m_compact_cursor == offset(next)) m_compact_cursor = offset(b);
+                        insert_free(b);
+                        continue;
+                    }
+                    b = next;
+                }
+            }
+
+            size_t              m_bytes_allocated;  // payload bytes of used blocks
+            size_t              m_bytes_peak;
+            size_t              m_bytes_committed;  // pages from m_buffer up to here are readable and writable
+            size_t              m_buffer_size;
+            char*               m_buffer;
+
+        private:
+            // Free list links, stored in the payload of free blocks as header offsets
+            struct links
+            {
+                size_t next;
+                size_t prev;
+            };
+
+            size_t              m_release_threshold;
+            bool                m_owns_buffer;
+            size_t              m_compact_cursor;   // header offset where the next compact() call resumes
+            relocate_fn         m_relocate;
+            void*               m_relocate_user;
+            uint64_t            m_fl_bitmap;
+            uint32_t            m_sl_bitmap[fl_count];
+            size_t              m_heads[fl_count][sl_count];
+
+            static unsigned msb(size_t v) { return 63 - (unsigned)__builtin_clzll((unsigned long long)v); }
+            static unsigned lsb(uint64_t v) { return (unsigned)__builtin_ctzll(v); }
+
+            static size_t adjust(size_t size)
+            {
+                size = (size + alignment - 1) / alignment * alignment;
+                return size < min_block ? min_block : size;
+            }
+
+            static void mapping_insert(size_t size, unsigned& fl, unsigned& sl)
+            {
+                if (size < (size_t(1) << fl_shift))
+                {
+                    fl = 0;
+                    sl = (unsigned)(size / alignment);
+                }
+                else
+                {
+                    unsigned bit = msb(size);
+                    sl = (unsigned)(size >> (bit - sl_log2)) ^ sl_count;
+                    fl = bit - fl_shift + 1;
+                }
+            }
+
+            // Rounds the request up to the next bin so any block found in it is big enough
+            static void mapping_search(size_t size, unsigned& fl, unsigned& sl)
+            {
+                if (size >= (size_t(1) << fl_shift)) size += (size_t(1) << (msb(size) - sl_log2)) - 1;
+                mapping_insert(size, fl, sl);
+            }
+
+            block* header(size_t offset) { return offset == none ? NULL : (block*)&m_buffer[offset]; }
+            size_t offset(block* b) { return (size_t)((char*)b - m_buffer); }
+            links* links_of(block* b) { return (links*)&m_buffer[b->pos]; }
+
+            block* physical_next(block* b)
+            {
+                size_t next = b->pos + b->bytes();
+                return next < m_buffer_size ? (block*)&m_buffer[next] : NULL;
+            }
+
+            // Merges a block that just stopped being used with its free neighbors and files it as free
+            void coalesce(block* _block)
+            {
+                // merge with the preceding block when it is free, its footer gives its header
+                if (_block->is_prev_free())
+                {
+                    block* prev = header(*((size_t*)_block - 1));
+                    remove_free(prev);
+                    prev->size = (prev->bytes() + sizeof(block) + _block->bytes()) | (prev->size & prev_free_bit);
+                    if (m_compact_cursor == offset(_block)) m_compact_cursor = offset(prev);
+#if OWL_MEMORY_DEBUG
+                    // the header stays behind in the payload of the merged block, mark it so a second free is caught
+                    _block->size |= free_bit;
+#endif
+                    _block = prev;
+                }
+
+                // merge with the following block when it is free
+                block* next = physical_next(_block);
+                if (next != NULL && next->is_free())
+                {
+                    remove_free(next);
+                    _block->size = (_block->bytes() + sizeof(block) + next->bytes()) | (_block->size & prev_free_bit);
+                    if (m_compact_cursor == offset(next)) m_compact_cursor = offset(_block);
+#if OWL_MEMORY_DEBUG
+                    next->size |= free_bit;
+#endif
+                }
+
+                // insert this block as a free block.
+                insert_free(_block);
+                if (m_release_threshold != 0 && _block->bytes() >= m_release_threshold) release_pages(_block);
+            }
+
+            // Swaps the free block _hole with the movable block _used right after it, returns the hole in its
+            // new place, merged with whatever free block followed _used
+            block* slide(block* _hole, block* _used)
+            {
+                size_t hole_bytes = _hole->bytes();
+                size_t used_bytes = _used->bytes();
+                char* from = &m_buffer[_used->pos];
+                remove_free(_hole);
+
+                // _hole's predecessor is in use, so the moved block starts with a clear prev_free_bit
+                block* moved = _hole;
+                memmove(&m_buffer[moved->pos], from, used_bytes);
+                moved->size = used_bytes | movable_bit;
+
+                block* hole = (block*)&m_buffer[moved->pos + used_bytes];
+                hole->pos = moved->pos + used_bytes + sizeof(block);
+                hole->size = hole_bytes;
+                coalesce(hole);
+
+                if (m_relocate != NULL) m_relocate(from, &m_buffer[moved->pos], used_bytes, m_relocate_user);
+                return hole;
+            }
+
+#if OWL_MEMORY_DEBUG
+            static void debug_fail(const char* what, const void* ptr)
+            {
+                std::cerr << "owl::memory: " << what << " at " << ptr << std::endl;
+                abort();
+            }
+
+            // The requested size goes in the last word of the payload, the bytes between it and the request are guards
+            void set_guard(block* b, size_t requested)
+            {
+                char* payload = &m_buffer[b->pos];
+                size_t* trailer = (size_t*)(payload + b->bytes() - sizeof(size_t));
+                *trailer = requested;
+                memset(payload + requested, guard_fill, (char*)trailer - (payload + requested));
+            }
+
+            void check_block(block* b)
+            {
+                if ((char*)b < m_buffer || (char*)b >= m_buffer + m_bytes_committed || b->pos != offset(b) + sizeof(block))
+                {
+                    debug_fail("free of a pointer that is not a block", b);
+                }
+                if (b->is_free()) debug_fail("double free", &m_buffer[b->pos]);
+                char* payload = &m_buffer[b->pos];
+                size_t* trailer = (size_t*)(payload + b->bytes() - sizeof(size_t));
+                if (*trailer > b->bytes() - guard_size - sizeof(size_t)) debug_fail("block trailer overwritten", payload);
+                for (char* g = payload + *trailer; g != (char*)trailer; g++)
+                {
+                    if ((unsigned char)*g != guard_fill) debug_fail("guard bytes overwritten", payload);
+                }
+            }
+#endif
+
+            // Makes [0, end) accessible, returns false when the kernel refuses
+            bool commit(size_t end)
+            {
+                if (end <= m_bytes_committed) return true;
+#if defined(__linux__)
+                size_t target = (end + commit_granularity - 1) / commit_granularity * commit_granularity;
+                if (target > m_buffer_size) target = m_buffer_size;
+                if (mprotect(m_buffer + m_bytes_committed, target - m_bytes_committed, PROT_READ|PROT_WRITE) != 0) return false;
+                m_bytes_committed = target;
+                return true;
+#else
+                return false;
+#endif
+            }
+
+            // Lets the OS reclaim the whole pages of a free block, keeping its links and footer
+            void release_pages(block* b)
+            {
+#if defined(__linux__)
+                static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+                size_t first = (b->pos + sizeof(links) + page - 1) / page * page;
+                size_t last = (b->pos + b->bytes() - sizeof(size_t)) / page * page;
+                if (last > m_bytes_committed) last = m_bytes_committed / page * page;
+                if (first >= last) return;
+#if defined(MADV_FREE)
+                madvise(m_buffer + first, last - first, MADV_FREE);
+#else
+                madvise(m_buffer + first, last - first, MADV_DONTNEED);
+#endif
+#endif
+            }
+
+            block* find_suitable(unsigned fl, unsigned sl)
+            {
+                if (fl >= fl_count) return NULL;
+                uint32_t sl_map = m_sl_bitmap[fl] & (~0u << sl);
+                if (sl_map == 0)
+                {
+                    uint64_t fl_map = fl+1 < 64 ? m_fl_bitmap & (~uint64_t(0) << (fl+1)) : 0;
+                    if (fl_map == 0) return NULL;
+                    fl = lsb(fl_map);
+                    sl_map = m_sl_bitmap[fl];
+                }
+                sl = lsb(sl_map);
+                return header(m_heads[fl][sl]);
+            }
+
+            block* search_bin(size_t size)
+            {
+                unsigned fl, sl;
+                mapping_insert(size, fl, sl);
+                for (block* b = header(m_heads[fl][sl]); b != NULL; b = header(links_of(b)->next))
+                {
+                    if (b->bytes() >= size) return b;
+                }
+                return NULL;
+            }
+
+            // Also writes the footer and flags the physical successor.
+            // The last block has no successor to read its footer, so its pages past the links stay untouched.
+            void insert_free(block* b)
+            {
+                b->size |= free_bit;
+                block* next = physical_next(b);
+                if (next != NULL)
+                {
+                    *(size_t*)&m_buffer[b->pos + b->bytes() - sizeof(size_t)] = offset(b);
+                    next->size |= prev_free_bit;
+                }
+                unsigned fl, sl;
+                mapping_insert(b->bytes(), fl, sl);
+                links* l = links_of(b);
+                l->prev = none;
+                l->next = m_heads[fl][sl];
+                if (l->next != none) links_of(header(l->next))->prev = offset(b);
+                m_heads[fl][sl] = offset(b);
+                m_fl_bitmap |= uint64_t(1) << fl;
+                m_sl_bitmap[fl] |= 1u << sl;
+            }
+
+            void remove_free(block* b)
+            {
+                unsigned fl, sl;
+                mapping_insert(b->bytes(), fl, sl);
+                links* l = links_of(b);
+                if (l->prev != none) links_of(header(l->prev))->next = l->next;
+                else m_heads[fl][sl] = l->next;
+                if (l->next != none) links_of(header(l->next))->prev = l->prev;
+                if (m_heads[fl][sl] == none)
+                {
+                    m_sl_bitmap[fl] &= ~(1u << sl);
+                    if (m_sl_bitmap[fl] == 0) m_fl_bitmap &= ~(uint64_t(1) << fl);
+                }
+                b->size &= ~free_bit;
+            }
+    };
+}
+
+inline void * operator new (std::size_t size, owl::memory& mem)
+{
+    void* p = mem.allocate(size);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+// Called when a constructor throws inside new (mem) T
+inline void operator delete (void* p, owl::memory& mem)
+{
+    mem.free_block((owl::memory::block*)((char*)p - sizeof(owl::memory::block)));
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include "memory_manager.h"
+
+namespace owl {
+    // std::pmr::memory_resource over an owl::memory, for std::pmr containers.
+    // Alignments above memory::alignment are served by memory::allocate_aligned.
+    class memory_resource : public std::pmr::memory_resource
+    {
+        public:
+            explicit memory_resource(memory& _memory) : m_memory(_memory) {}
+
+            memory& arena() const { return m_memory; }
+
+        private:
+            memory&     m_memory;
+
+            void* do_allocate(size_t bytes, size_t align) override
+            {
+                void* p = m_memory.allocate_aligned(bytes, align);
+                if (p == NULL) throw std::bad_alloc();
+                return p;
+            }
+
+            void do_deallocate(void* p, size_t, size_t align) override
+            {
+                m_memory.free_aligned(p, align);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+            {
+                const memory_resource* o = dynamic_cast<const memory_resource*>(&other);
+                return o != NULL && &o->m_memory == &m_memory;
+            }
+    };
+
+    // Stateful STL allocator over an owl::memory: std::vector<int, owl::allocator<int>> v(owl::allocator<int>(mem));
+    // Containers carry the arena along when they are copied, moved or swapped.
+    template <class T>
+    class allocator
+    {
+        public:
+            typedef T value_type;
+            typedef std::true_type propagate_on_container_copy_assignment;
+            typedef std::true_type propagate_on_container_move_assignment;
+            typedef std::true_type propagate_on_container_swap;
+            typedef std::false_type is_always_equal;
+
+            explicit allocator(memory& _memory) noexcept : m_memory(&_memory) {}
+
+            template <class U>
+            allocator(const allocator<U>& other) noexcept : m_memory(other.arena()) {}
+
+            T* allocate(size_t n)
+            {
+                if (n > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+                void* p = m_memory->allocate_aligned(n * sizeof(T), alignof(T));
+                if (p == NULL) throw std::bad_alloc();
+                return static_cast<T*>(p);
+            }
+
+            void deallocate(T* p, size_t) noexcept
+            {
+                m_memory->free_aligned(p, alignof(T));
+            }
+
+            memory* arena() const noexcept { return m_memory; }
+
+            template <class U>
+            bool operator==(const allocator<U>& other) const noexcept { return m_memory == other.arena(); }
+
+            template <class U>
+            bool operator!=(const allocator<U>& other) const noexcept { return m_memory != other.arena(); }
+
+        private:
+            memory*     m_memory;
+    };
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include "memory_manager.h"
+
+namespace owl {
+    // Size-class front end for small allocations on top of an owl::memory.
+    // Requests up to max_small bytes are rounded to a power of two class (8, 16, 32 ... 256) and served from
+    // slabs of that class: no per-object header, occupancy is one bit per slot in the slab header.
+    // Slabs are slab_size aligned so the slab of any slot is found by masking its address; they are carved
+    // from chunks of slabs_per_chunk slabs taken from the arena in one aligned allocation.
+    // Larger requests go straight to the arena. Frees are sized, like std::allocator and pmr.
+    class small_memory
+    {
+        public:
+            static const size_t   max_small       = 256;
+            static const unsigned class_count     = 6;
+            static const size_t   slab_size       = size_t(64) << 10;
+            static const size_t   slabs_per_chunk = 16;
+
+            small_memory()
+            {
+                m_arena = NULL;
+            }
+
+            small_memory(const small_memory&) = delete;
+            small_memory& operator=(const small_memory&) = delete;
+
+            ~small_memory()
+            {
+                terminate();
+            }
+
+            void init (memory& _arena)
+            {
+                if (m_arena!=NULL) return;
+
+                m_arena = &_arena;
+                m_chunks = NULL;
+                m_free_slabs = NULL;
+                m_slabs_in_use = 0;
+                for (unsigned c=0; c<class_count; c++) m_partial[c] = NULL;
+            }
+
+            // Gives every chunk back to the arena, small objects still alive are lost
+            void terminate()
+            {
+                if (m_arena == NULL) return;
+                while (m_chunks != NULL)
+                {
+                    slab* next = m_chunks->chunk_next;
+                    m_arena->free_aligned(m_chunks, slab_size);
+                    m_chunks = next;
+                }
+                m_arena = NULL;
+            }
+
+            // Returns NULL when the arena is full
+            void* allocate(size_t size)
+            {
+                if (size > max_small) return m_arena->allocate(size);
+
+                unsigned c = class_of(size);
+                slab* s = m_partial[c];
+                if (s == NULL)
+                {
+                    s = new_slab(c);
+                    if (s == NULL) return NULL;
+                }
+
+                // first clear bit at or after the hint word
+                unsigned w = s->hint;
+                while (s->used_bits[w] == ~uint64_t(0)) w++;
+                unsigned bit = (unsigned)__builtin_ctzll(~s->used_bits[w]);
+                s->used_bits[w] |= uint64_t(1) << bit;
+                s->hint = w;
+                if (++s->used == s->capacity) unlink(s);
+                return (char*)s + s->first + (size_t(w)*64 + bit) * s->slot_size;
+            }
+
+            // _size must be the size given to allocate
+            void deallocate(void* _ptr, size_t _size)
+            {
+                if (_size > max_small)
+                {
+                    m_arena->free_block(memory::block_of(_ptr));
+                    return;
+                }
+
+                slab* s = slab_of(_ptr);
+                size_t slot = ((char*)_ptr - ((char*)s + s->first)) / s->slot_size;
+                unsigned w = (unsigned)(slot / 64);
+                assert((s->used_bits[w] >> (slot % 64) & 1) && "owl::small_memory: double free");
+                s->used_bits[w] &= ~(uint64_t(1) << (slot % 64));
+                if (w < s->hint) s->hint = w;
+
+                if (s->used-- == s->capacity) link(s);
+                // keep one slab per class so a class at the edge of empty does not churn slabs
+                if (s->used == 0 && (s->prev != NULL || s->next != NULL)) release_slab(s);
+            }
+
+            // Rounded size a request is served with, requests above max_small are not rounded
+            static size_t size_class(size_t size)
+            {
+                return size > max_small ? size : size_t(8) << class_of(size);
+            }
+
+            size_t slabs_in_use() const { return m_slabs_in_use; }
+
+        private:
+            static const unsigned max_slots = slab_size / 8;
+
+            struct slab
+            {
+                slab*       next;       // partial list of the class, only while the slab has free slots
+                slab*       prev;
+                uint32_t    slot_size;
+                uint32_t    first;      // offset of slot 0 from the slab
+                uint32_t    capacity;
+                uint32_t    used;
+                uint32_t    hint;       // no free slot before this bitmap word
+                uint32_t    size_class;
+                slab*       chunk_next; // set in the first slab of a chunk, links the chunks
+                uint64_t    used_bits[max_slots / 64];
+            };
+
+            memory*     m_arena;
+            slab*       m_chunks;       // first slab of every chunk
+            slab*       m_free_slabs;   // empty slabs of any class, linked through next
+            slab*       m_partial[class_count];
+            size_t      m_slabs_in_use;
+
+            static unsigned class_of(size_t size)
+            {
+                if (size <= 8) return 0;
+                return 64 - (unsigned)__builtin_clzll((unsigned long long)(size - 1)) - 3;
+            }
+
+            static slab* slab_of(void* p)
+            {
+                return (slab*)((uintptr_t)p & ~(uintptr_t)(slab_size - 1));
+            }
+
+            void link(slab* s)
+            {
+                s->prev = NULL;
+                s->next = m_partial[s->size_class];
+                if (s->next != NULL) s->next->prev = s;
+                m_partial[s->size_class] = s;
+            }
+
+            void unlink(slab* s)
+            {
+                if (s->prev != NULL) s->prev->next = s->next;
+                else m_partial[s->size_class] = s->next;
+                if (s->next != NULL) s->next->prev = s->prev;
+                s->next = s->prev = NULL;
+            }
+
+            slab* new_slab(unsigned c)
+            {
+                if (m_free_slabs == NULL && !new_chunk()) return NULL;
+                slab* s = m_free_slabs;
+                m_free_slabs = s->next;
+
+                size_t slot_size = size_t(8) << c;
+                size_t align = slot_size < memory::alignment ? slot_size : memory::alignment;
+                size_t first = (sizeof(slab) + align - 1) / align * align;
+                s->slot_size = (uint32_t)slot_size;
+                s->first = (uint32_t)first;
+                s->capacity = (uint32_t)((slab_size - first) / slot_size);
+                s->used = 0;
+                s->hint = 0;
+                s->size_class = c;
+                memset(s->used_bits, 0, sizeof(s->used_bits));
+                // slots past the capacity read as used so the bit scan never runs off the end
+                for (size_t i=s->capacity; i<max_slots; i++) s->used_bits[i / 64] |= uint64_t(1) << (i % 64);
+                link(s);
+                m_slabs_in_use++;
+                return s;
+            }
+
+            void release_slab(slab* s)
+            {
+                unlink(s);
+                s->next = m_free_slabs;
+                m_free_slabs = s;
+                m_slabs_in_use--;
+            }
+
+            // The alignment costs one slab worth of slack per chunk
+            bool new_chunk()
+            {
+                char* chunk = (char*)m_arena->allocate_aligned(slabs_per_chunk * slab_size, slab_size);
+                if (chunk == NULL) return false;
+                ((slab*)chunk)->chunk_next = m_chunks;
+                m_chunks = (slab*)chunk;
+                for (size_t i=0; i<slabs_per_chunk; i++)
+                {
+                    slab* s = (slab*)(chunk + i * slab_size);
+                    s->next = m_free_slabs;
+                    m_free_slabs = s;
+                }
+                return true;
+            }
+    };
+}
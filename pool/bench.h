@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+// Small microbenchmark harness: warmup runs, repeated timed trials, median and p99 per operation.
+namespace bench
+{
+    // Keeps the compiler from discarding a value or the computation that produced it
+    template <class T>
+    inline void do_not_optimize(T const& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const T* sink;
+        sink = &value;
+#endif
+    }
+
+    // Forces pending writes to memory to be considered observable
+    inline void clobber_memory()
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : : "memory");
+#endif
+    }
+
+    struct result
+    {
+        double median_ns = 0;   // per operation
+        double p99_ns = 0;
+        double min_ns = 0;
+        size_t trials = 0;
+    };
+
+    struct options
+    {
+        size_t warmup = 3;
+        size_t trials = 51;
+    };
+
+    // Every trial calls setup() untimed, times body(state), then calls teardown(state) untimed.
+    // ops is the number of operations one body call performs.
+    template <class Setup, class Body, class Teardown>
+    result run(size_t ops, Setup&& setup, Body&& body, Teardown&& teardown, options opt = options())
+    {
+        std::vector<double> samples;
+        samples.reserve(opt.trials);
+        for (size_t i=0; i<opt.warmup+opt.trials; i++)
+        {
+            auto state = setup();
+            clobber_memory();
+            auto startTime = std::chrono::steady_clock::now();
+            body(state);
+            clobber_memory();
+            auto endTime = std::chrono::steady_clock::now();
+            teardown(state);
+            if (i >= opt.warmup) samples.push_back(std::chrono::duration<double, std::nano>(endTime - startTime).count() / ops);
+        }
+
+        std::sort(samples.begin(), samples.end());
+        result r;
+        r.trials = samples.size();
+        r.min_ns = samples.front();
+        r.median_ns = samples[samples.size()/2];
+        r.p99_ns = samples[std::min(samples.size()-1, (size_t)(samples.size()*0.99))];
+        return r;
+    }
+
+    inline void print_header()
+    {
+        std::printf("%-14s %-16s %12s %12s %12s\n", "scenario", "allocator", "median ns", "p99 ns", "min ns");
+    }
+
+    inline void print(const char* scenario, const char* allocator, const result& r)
+    {
+        std::printf("%-14s %-16s %12.2f %12.2f %12.2f\n", scenario, allocator, r.median_ns, r.p99_ns, r.min_ns);
+    }
+}
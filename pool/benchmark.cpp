@@ -0,0 +1,277 @@
+// Pool microbenchmarks: ecs::Pool against std::make_shared, new/delete and std::pmr pools.
+// g++ -std=c++20 -O2 -DNDEBUG benchmark.cpp -o benchmark
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <vector>
+#include "bench.h"
+#include "packed_pool.h"
+#include "pool.h"
+
+namespace
+{
+    struct payload
+    {
+        payload(int p_id) : id(p_id) {}
+
+        int id;
+        float position[3] = {};
+        float velocity[3] = {};
+        uint64_t flags = 0;
+        char name[24] = {};
+    };
+
+    const size_t numItems = 100000;
+
+    struct pool_allocator
+    {
+        static constexpr const char* name = "ecs::Pool";
+        using ref = payload*;
+
+        ecs::Pool<payload> pool{4096};
+
+        ref make(int id) {return pool.allocate(id);}
+        void release(ref& r) {pool.deallocate(r);}
+        int  value(const ref& r) {return r->id;}
+
+        template <class Visit>
+        void for_each(std::vector<ref>&, Visit&& visit) { for (payload* p : pool) visit(*p); }
+    };
+
+    struct shared_allocator
+    {
+        static constexpr const char* name = "make_shared";
+        using ref = std::shared_ptr<payload>;
+
+        ref make(int id) {return std::make_shared<payload>(id);}
+        void release(ref& r) {r.reset();}
+        int  value(const ref& r) {return r->id;}
+
+        template <class Visit>
+        void for_each(std::vector<ref>& refs, Visit&& visit) { for (ref& r : refs) visit(*r); }
+    };
+
+    struct heap_allocator
+    {
+        static constexpr const char* name = "new/delete";
+        using ref = payload*;
+
+        ref make(int id) {return new payload(id);}
+        void release(ref& r) {delete r;}
+        int  value(const ref& r) {return r->id;}
+
+        template <class Visit>
+        void for_each(std::vector<ref>& refs, Visit&& visit) { for (ref r : refs) visit(*r); }
+    };
+
+    struct pmr_allocator
+    {
+        static constexpr const char* name = "pmr pool";
+        using ref = payload*;
+
+        std::pmr::unsynchronized_pool_resource resource;
+        std::pmr::polymorphic_allocator<payload> alloc{&resource};
+
+        ref make(int id)
+        {
+            payload* p = alloc.allocate(1);
+            alloc.construct(p, id);
+            return p;
+        }
+        void release(ref& r)
+        {
+            std::destroy_at(r);
+            alloc.deallocate(r, 1);
+        }
+        int  value(const ref& r) {return r->id;}
+
+        template <class Visit>
+        void for_each(std::vector<ref>& refs, Visit&& visit) { for (ref r : refs) visit(*r); }
+    };
+
+    // Objects held during one trial. The allocator outlives the trials of a scenario, so every allocator
+    // gets to reuse its own memory instead of paying first-touch page faults on each trial.
+    template <class A>
+    struct state
+    {
+        A* alloc;
+        std::vector<typename A::ref> refs;
+
+        void fill(size_t count)
+        {
+            refs.reserve(count);
+            for (size_t i=0; i<count; i++) refs.push_back(alloc->make((int)i));
+        }
+
+        void clear()
+        {
+            for (auto& r : refs) alloc->release(r);
+            refs.clear();
+        }
+    };
+
+    template <class A>
+    void allocate_only()
+    {
+        auto alloc = std::make_unique<A>();
+        auto r = bench::run(numItems,
+            [&] { state<A> s{alloc.get(), {}}; s.refs.reserve(numItems); return s; },
+            [](state<A>& s) { for (size_t i=0; i<numItems; i++) s.refs.push_back(s.alloc->make((int)i)); },
+            [](state<A>& s) { s.clear(); });
+        bench::print("allocate", A::name, r);
+    }
+
+    template <class A>
+    void free_only()
+    {
+        auto alloc = std::make_unique<A>();
+        auto r = bench::run(numItems,
+            [&] { state<A> s{alloc.get(), {}}; s.fill(numItems); return s; },
+            [](state<A>& s) { for (auto& ref : s.refs) s.alloc->release(ref); s.refs.clear(); },
+            [](state<A>& s) { s.clear(); });
+        bench::print("free", A::name, r);
+    }
+
+    // Replaces a random live object per step
+    template <class A>
+    void churn()
+    {
+        auto alloc = std::make_unique<A>();
+        std::mt19937 rng(1234);
+        std::uniform_int_distribution<size_t> pick(0, numItems-1);
+        std::vector<size_t> victims(numItems);
+        for (size_t& v : victims) v = pick(rng);
+
+        auto r = bench::run(numItems,
+            [&] { state<A> s{alloc.get(), {}}; s.fill(numItems); return s; },
+            [&](state<A>& s)
+            {
+                for (size_t i=0; i<numItems; i++)
+                {
+                    auto& ref = s.refs[victims[i]];
+                    s.alloc->release(ref);
+                    ref = s.alloc->make((int)i);
+                }
+            },
+            [](state<A>& s) { s.clear(); });
+        bench::print("churn", A::name, r);
+    }
+
+    // Touches every live object after a churn phase scattered them
+    template <class A>
+    void iterate()
+    {
+        auto alloc = std::make_unique<A>();
+        std::mt19937 rng(99);
+        std::uniform_int_distribution<size_t> pick(0, numItems-1);
+
+        auto r = bench::run(numItems,
+            [&]
+            {
+                state<A> s{alloc.get(), {}};
+                s.fill(numItems);
+                for (size_t i=0; i<numItems; i++)
+                {
+                    auto& ref = s.refs[pick(rng)];
+                    s.alloc->release(ref);
+                    ref = s.alloc->make((int)i);
+                }
+                return s;
+            },
+            [](state<A>& s)
+            {
+                int64_t sum = 0;
+                s.alloc->for_each(s.refs, [&](payload& p) { sum += p.id; p.position[0] += 1.0f; });
+                bench::do_not_optimize(sum);
+            },
+            [](state<A>& s) { s.clear(); });
+        bench::print("iterate", A::name, r);
+    }
+
+    // Random mix of 40% allocations, 40% frees and 20% reads around a live set of numItems/2
+    template <class A>
+    void mixed()
+    {
+        auto alloc = std::make_unique<A>();
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> op(0, 99);
+        std::vector<int> ops(numItems);
+        std::vector<uint32_t> picks(numItems);
+        for (size_t i=0; i<numItems; i++)
+        {
+            ops[i] = op(rng);
+            picks[i] = (uint32_t)rng();
+        }
+
+        auto r = bench::run(numItems,
+            [&] { state<A> s{alloc.get(), {}}; s.fill(numItems/2); s.refs.reserve(numItems*2); return s; },
+            [&](state<A>& s)
+            {
+                int64_t sum = 0;
+                for (size_t i=0; i<numItems; i++)
+                {
+                    if (ops[i] < 40 || s.refs.empty())
+                    {
+                        s.refs.push_back(s.alloc->make((int)i));
+                    }
+                    else if (ops[i] < 80)
+                    {
+                        auto& ref = s.refs[picks[i] % s.refs.size()];
+                        s.alloc->release(ref);
+                        ref = std::move(s.refs.back());
+                        s.refs.pop_back();
+                    }
+                    else
+                    {
+                        sum += s.alloc->value(s.refs[picks[i] % s.refs.size()]);
+                    }
+                }
+                bench::do_not_optimize(sum);
+            },
+            [](state<A>& s) { s.clear(); });
+        bench::print("mixed", A::name, r);
+    }
+
+    template <class A>
+    void run_all()
+    {
+        allocate_only<A>();
+        free_only<A>();
+        churn<A>();
+        iterate<A>();
+        mixed<A>();
+    }
+
+    // Dense iteration reference: the same sweep over a PackedPool
+    void iterate_packed()
+    {
+        auto r = bench::run(numItems,
+            []
+            {
+                auto pool = std::make_unique<ecs::PackedPool<payload>>(numItems);
+                for (size_t i=0; i<numItems; i++) pool->create((int)i);
+                return pool;
+            },
+            [](std::unique_ptr<ecs::PackedPool<payload>>& pool)
+            {
+                int64_t sum = 0;
+                for (payload* p : *pool) { sum += p->id; p->position[0] += 1.0f; }
+                bench::do_not_optimize(sum);
+            },
+            [](std::unique_ptr<ecs::PackedPool<payload>>&) {});
+        bench::print("iterate", "ecs::PackedPool", r);
+    }
+}
+
+int main()
+{
+    bench::print_header();
+    run_all<pool_allocator>();
+    run_all<shared_allocator>();
+    run_all<heap_allocator>();
+    run_all<pmr_allocator>();
+    iterate_packed();
+    return 0;
+}
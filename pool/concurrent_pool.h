@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cassert>
+
+namespace ecs
+{
+    // Fixed-size pool for T that can be used from many threads at once.
+    // Every thread allocates from its own heap: a local free list (the magazine) refilled from private slabs.
+    // Freeing from the owning thread pushes to that local list without atomics. Freeing from another thread
+    // pushes the slot to the owner's remote list, a lock-free multi-producer stack that only the owner drains,
+    // taking the whole list at once so it is immune to ABA.
+    // When a thread exits its heaps are marked abandoned, and the next thread that starts using the pool adopts
+    // one with its free slots and pending remote frees, so thread churn does not grow the pool. Heaps nobody
+    // adopts are released with the pool.
+    template <class T>
+    class ConcurrentPool
+    {
+    private:
+        struct heap;
+
+        struct slot
+        {
+            // While the slot is free the storage is reused as the link to the next free slot
+            union
+            {
+                alignas(T) std::byte storage[sizeof(T)];
+                slot* next_free;
+            };
+            heap* owner;
+            bool  live;
+
+            T* object() { return std::launder(reinterpret_cast<T*>(storage)); }
+        };
+
+        struct alignas(64) heap
+        {
+            bool                abandoned = false;  // guarded by the pool's m_mutex
+            slot*               free = nullptr;     // owner-only free list
+            slot*               bump = nullptr;     // untouched slots of the current slab
+            slot*               bump_end = nullptr;
+            std::vector<slot*>  slabs;
+            alignas(64) std::atomic<slot*> remote_free{nullptr}; // pushed by other threads
+        };
+
+        // Every pool of this T the thread has a heap in, looked up without a lock. Threads touch few pools,
+        // so a linear scan beats hashing, and switching between pools costs a couple of compares.
+        struct thread_state
+        {
+            std::vector<std::pair<uint64_t, heap*>> heaps;
+
+            // Hands the heaps of pools still alive back to them
+            ~thread_state()
+            {
+                registry& r = live_pools();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                for (const std::pair<uint64_t, heap*>& entry : heaps)
+                {
+                    auto it = r.pools.find(entry.first);
+                    if (it != r.pools.end()) it->second->abandon(entry.second);
+                }
+            }
+        };
+
+        // Pools of this T by id. An exiting thread holds the lock while it touches a pool, and a pool leaves the
+        // registry before its heaps are deleted.
+        struct registry
+        {
+            std::mutex mutex;
+            std::unordered_map<uint64_t, ConcurrentPool*> pools;
+        };
+
+        static registry& live_pools()
+        {
+            static registry r;
+            return r;
+        }
+
+        static uint64_t next_pool_id()
+        {
+            static std::atomic<uint64_t> id{0};
+            return ++id;
+        }
+
+        static thread_state& local()
+        {
+            static thread_local thread_state state;
+            return state;
+        }
+
+        const uint64_t      m_id = next_pool_id();
+        const size_t        m_slab_size;
+        std::mutex          m_mutex;    // guards m_heaps, only taken the first time a thread uses the pool
+        std::vector<heap*>  m_heaps;
+
+        heap* local_heap()
+        {
+            for (const std::pair<uint64_t, heap*>& entry : local().heaps)
+            {
+                if (entry.first == m_id) return entry.second;
+            }
+            return attach_thread();
+        }
+
+        heap* attach_thread()
+        {
+            std::vector<std::pair<uint64_t, heap*>>& heaps = local().heaps;
+            {
+                // forget pools destroyed since, their heaps are gone
+                registry& r = live_pools();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                heaps.erase(std::remove_if(heaps.begin(), heaps.end(), [&](const std::pair<uint64_t, heap*>& entry) { return r.pools.count(entry.first) == 0; }), heaps.end());
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            heap* h = nullptr;
+            for (heap* candidate : m_heaps)
+            {
+                if (candidate->abandoned) { h = candidate; break; }
+            }
+            if (h) h->abandoned = false;
+            else
+            {
+                h = new heap();
+                m_heaps.push_back(h);
+            }
+            heaps.emplace_back(m_id, h);
+            return h;
+        }
+
+        void abandon(heap* h)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            h->abandoned = true;
+        }
+
+        slot* refill(heap* h)
+        {
+            // Take everything other threads returned in one exchange
+            slot* returned = h->remote_free.exchange(nullptr, std::memory_order_acquire);
+            if (returned) return returned;
+
+            if (h->bump == h->bump_end)
+            {
+                slot* s = static_cast<slot*>(::operator new(sizeof(slot)*m_slab_size, std::align_val_t{alignof(slot)}));
+                h->slabs.push_back(s);
+                h->bump = s;
+                h->bump_end = s + m_slab_size;
+            }
+            slot* sl = h->bump++;
+            sl->owner = h;
+            sl->live = false;
+            sl->next_free = nullptr;
+            return sl;
+        }
+
+    public:
+        // slab_size is the number of objects each thread carves at once
+        ConcurrentPool(size_t slab_size) : m_slab_size(slab_size)
+        {
+            if (slab_size == 0) throw std::invalid_argument("ecs::ConcurrentPool: invalid slab size");
+            registry& r = live_pools();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.pools.emplace(m_id, this);
+        }
+
+        ConcurrentPool(const ConcurrentPool&) = delete;
+        ConcurrentPool& operator=(const ConcurrentPool&) = delete;
+
+        // No thread may use the pool while it is destroyed
+        ~ConcurrentPool()
+        {
+            {
+                registry& r = live_pools();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                r.pools.erase(m_id);
+            }
+            for (heap* h : m_heaps)
+            {
+                for (slot* s : h->slabs)
+                {
+                    slot* end = (s + m_slab_size == h->bump_end) ? h->bump : s + m_slab_size;
+                    for (slot* sl = s; sl != end; ++sl)
+                    {
+                        if (sl->live) sl->object()->~T();
+                    }
+                    ::operator delete(s, std::align_val_t{alignof(slot)});
+                }
+                delete h;
+            }
+        }
+
+        size_t thread_heaps()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_heaps.size();
+        }
+
+        template<typename... Args>
+        T* allocate(Args&&... args)
+        {
+            heap* h = local_heap();
+            slot* sl = h->free ? h->free : refill(h);
+            h->free = sl->next_free;
+            try
+            {
+                new (sl->storage) T(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                sl->next_free = h->free;
+                h->free = sl;
+                throw;
+            }
+            sl->live = true;
+            return sl->object();
+        }
+
+        // Can be called from any thread
+        void deallocate(T* ptr)
+        {
+            slot* sl = reinterpret_cast<slot*>(ptr);
+            assert(sl->live && "ecs::ConcurrentPool: double free");
+            ptr->~T();
+            sl->live = false;
+
+            heap* owner = sl->owner;
+            heap* h = local_heap();
+            if (owner == h)
+            {
+                sl->next_free = h->free;
+                h->free = sl;
+                return;
+            }
+
+            slot* head = owner->remote_free.load(std::memory_order_relaxed);
+            do
+            {
+                sl->next_free = head;
+            }
+            while (!owner->remote_free.compare_exchange_weak(head, sl, std::memory_order_release, std::memory_order_relaxed));
+        }
+    };
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include "pool.h"
+#include "example_churn.h"
+
+namespace ecs
+{
+    // Heap slabs, but only as many as the budget allows
+    struct capped_slab_source : heap_slab_source
+    {
+        size_t budget = 2;
+
+        void* acquire(size_t bytes, size_t align)
+        {
+            if (budget == 0) throw std::bad_alloc();
+            --budget;
+            return heap_slab_source::acquire(bytes, align);
+        }
+    };
+
+    // Spawns and despawns whole waves of particles, one call per object against one call per wave
+    inline int example_batch()
+    {
+        const size_t waves[] = {1000, 100000};
+
+        for (size_t wave : waves)
+        {
+            const size_t repeats = 20000000 / wave;
+            std::vector<particle*> v(wave);
+
+            {
+                ecs::Pool<particle> pool(4096);
+                auto startTime = std::chrono::steady_clock::now();
+                for (size_t r=0; r<repeats; r++)
+                {
+                    for (size_t i=0; i<wave; i++) v[i] = pool.allocate((int)i);
+                    for (size_t i=0; i<wave; i++) pool.deallocate(v[i]);
+                }
+                auto endTime = std::chrono::steady_clock::now();
+
+                auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime);
+                std::cout << "per object wave " << wave << ":\t" << (double)duration.count()/(repeats*wave) << " ns per object" << std::endl;
+            }
+
+            {
+                ecs::Pool<particle> pool(4096);
+                auto startTime = std::chrono::steady_clock::now();
+                for (size_t r=0; r<repeats; r++)
+                {
+                    pool.allocate_n(v, [](size_t i) {return particle((int)i);});
+                    pool.free_n(v);
+                }
+                auto endTime = std::chrono::steady_clock::now();
+
+                auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime);
+                std::cout << "batch wave " << wave << ":\t\t" << (double)duration.count()/(repeats*wave) << " ns per object" << std::endl;
+            }
+        }
+
+        // A batch that runs out of slabs halfway must give back what it took, so the same two slabs still hold
+        // a batch that fits in them
+        ecs::Pool<particle, handle64, alignof(particle), capped_slab_source> capped(64);
+        std::vector<particle*> first(10), too_many(200), fits(118);
+        capped.allocate_n(first);
+        bool threw = false;
+        try
+        {
+            capped.allocate_n(too_many);
+        }
+        catch (const std::bad_alloc&)
+        {
+            threw = true;
+        }
+        bool rolled_back = threw && capped.used_chunks() == first.size();
+        try
+        {
+            capped.allocate_n(fits);
+            capped.free_n(fits);
+        }
+        catch (const std::bad_alloc&)
+        {
+            rolled_back = false;
+        }
+        capped.free_n(first);
+        std::cout << "batch past the last slab:\t" << (rolled_back ? "rolled back" : "leaked") << std::endl;
+        return rolled_back ? 0 : 1;
+    }
+}
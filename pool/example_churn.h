@@ -0,0 +1,110 @@
+#pragma once
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "pool.h"
+
+namespace ecs
+{
+    struct particle
+    {
+        particle() {}
+        particle(int p_id) : id(p_id) {}
+
+        float x = 0, y = 0, z = 0;
+        int id = 0;
+    };
+
+    // Keeps `live` objects alive and replaces a random one per step, so every step is one free plus one allocation
+    inline int example_churn()
+    {
+        const size_t sizes[] = {10000, 100000, 1000000};
+        const size_t steps = 2000000;
+
+        for (size_t live : sizes)
+        {
+            std::mt19937 rng(1234);
+            std::uniform_int_distribution<size_t> pick(0, live-1);
+            std::vector<size_t> victims(steps);
+            for (size_t& v : victims) v = pick(rng);
+
+            // Pool
+            {
+                ecs::Pool<particle> pool(4096);
+                std::vector<particle*> v(live);
+                for (size_t i=0; i<live; i++) v[i] = pool.allocate((int)i);
+
+                auto startTime = std::chrono::steady_clock::now();
+                for (size_t i=0; i<steps; i++)
+                {
+                    particle*& p = v[victims[i]];
+                    pool.deallocate(p);
+                    p = pool.allocate((int)i);
+                }
+                auto endTime = std::chrono::steady_clock::now();
+
+                auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime);
+                std::cout << "Pool churn " << live << " live:\t" << (double)duration.count()/steps << " ns per free+alloc, "
+                          << (steps*1e3)/duration.count() << " M ops/s" << std::endl;
+            }
+
+            // new/delete
+            {
+                std::vector<particle*> v(live);
+                for (size_t i=0; i<live; i++) v[i] = new particle((int)i);
+
+                auto startTime = std::chrono::steady_clock::now();
+                for (size_t i=0; i<steps; i++)
+                {
+                    particle*& p = v[victims[i]];
+                    delete p;
+                    p = new particle((int)i);
+                }
+                auto endTime = std::chrono::steady_clock::now();
+
+                auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime);
+                std::cout << "new/delete churn " << live << " live:\t" << (double)duration.count()/steps << " ns per free+alloc, "
+                          << (steps*1e3)/duration.count() << " M ops/s" << std::endl;
+
+                for (particle* p : v) delete p;
+            }
+        }
+
+        return 0;
+    }
+
+    // A burst of one million objects followed by a mostly-empty steady state, showing what trim and compact give back
+    inline int example_spike()
+    {
+        const size_t burst = 1000000;
+        ecs::Pool<particle> pool(4096);
+        std::vector<ecs::Pool<particle>::handle> v(burst);
+        for (size_t i=0; i<burst; i++) v[i] = pool.create((int)i);
+        std::cout << "spike:\t\t" << pool.slab_count() << " slabs, " << pool.capacity() << " slots" << std::endl;
+
+        // Keep every 100th object alive, scattered over all slabs
+        size_t kept = 0;
+        for (size_t i=0; i<burst; i++)
+        {
+            if (i%100 == 0) v[kept++] = v[i];
+            else pool.destroy(v[i]);
+        }
+        v.resize(kept);
+        std::cout << "after free:\t" << pool.slab_count() << " slabs, occupancy " << pool.occupancy() << std::endl;
+
+        // The object id tells which entry of v holds the moved handle
+        auto startTime = std::chrono::steady_clock::now();
+        size_t moved = pool.compact(0.5, [&](ecs::Pool<particle>::handle, ecs::Pool<particle>::handle to, particle* p) {
+            v[p->id/100] = to;
+        });
+        size_t trimmed = pool.shrink_to_fit();
+        auto endTime = std::chrono::steady_clock::now();
+
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+        std::cout << "compacted:\t" << moved << " moved, " << trimmed << " trimmed, " << pool.slab_count() << " slabs, occupancy "
+                  << pool.occupancy() << " in " << duration.count() << " us" << std::endl;
+
+        return 0;
+    }
+}
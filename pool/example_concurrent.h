@@ -0,0 +1,92 @@
+#pragma once
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <thread>
+#include <vector>
+#include "concurrent_pool.h"
+
+namespace ecs
+{
+    struct tagged
+    {
+        tagged(uint32_t p_thread, uint32_t p_seq) : thread(p_thread), seq(p_seq), check(p_thread ^ p_seq ^ 0x5bd1e995u) {}
+
+        bool intact() const { return check == (thread ^ seq ^ 0x5bd1e995u); }
+
+        uint32_t thread, seq, check;
+        float payload[5] = {};
+    };
+
+    // Every round each thread allocates a batch, frees half of it locally, then frees the other half
+    // of its neighbour's batch so half of all frees cross threads. Objects are checked for corruption on free.
+    template <class Alloc, class Free>
+    inline double run_concurrent(unsigned threads, size_t rounds, size_t batch, Alloc alloc, Free release, size_t& corrupted)
+    {
+        std::vector<std::vector<tagged*>> batches(threads, std::vector<tagged*>(batch));
+        std::barrier sync(threads);
+        std::atomic<size_t> bad{0};
+
+        auto worker = [&](unsigned t)
+        {
+            std::vector<tagged*>& mine = batches[t];
+            std::vector<tagged*>& theirs = batches[(t+1)%threads];
+            for (size_t r=0; r<rounds; r++)
+            {
+                for (size_t i=0; i<batch; i++) mine[i] = alloc(t, (uint32_t)(r*batch+i));
+                for (size_t i=0; i<batch; i+=2)
+                {
+                    if (!mine[i]->intact()) ++bad;
+                    release(mine[i]);
+                }
+                sync.arrive_and_wait();
+                for (size_t i=1; i<batch; i+=2)
+                {
+                    if (!theirs[i]->intact() || theirs[i]->thread != (t+1)%threads) ++bad;
+                    release(theirs[i]);
+                }
+                sync.arrive_and_wait();
+            }
+        };
+
+        auto startTime = std::chrono::steady_clock::now();
+        std::vector<std::thread> pool;
+        for (unsigned t=0; t<threads; t++) pool.emplace_back(worker, t);
+        for (std::thread& th : pool) th.join();
+        auto endTime = std::chrono::steady_clock::now();
+
+        corrupted = bad;
+        double seconds = std::chrono::duration<double>(endTime - startTime).count();
+        return (2.0*threads*rounds*batch) / seconds / 1e6;
+    }
+
+    inline int example_concurrent(unsigned max_threads = std::thread::hardware_concurrency())
+    {
+        const size_t rounds = 200;
+        const size_t batch = 10000;
+        max_threads = std::max(1u, max_threads);
+
+        std::vector<unsigned> counts;
+        for (unsigned threads=1; threads<max_threads; threads*=2) counts.push_back(threads);
+        counts.push_back(max_threads);
+
+        for (unsigned threads : counts)
+        {
+            size_t corrupted = 0;
+            ecs::ConcurrentPool<tagged> pool(4096);
+            double pool_mops = run_concurrent(threads, rounds, batch,
+                [&](uint32_t t, uint32_t seq) { return pool.allocate(t, seq); },
+                [&](tagged* p) { pool.deallocate(p); }, corrupted);
+            std::cout << "ConcurrentPool " << threads << " threads:\t" << pool_mops << " M ops/s, corrupted " << corrupted << std::endl;
+
+            double heap_mops = run_concurrent(threads, rounds, batch,
+                [](uint32_t t, uint32_t seq) { return new tagged(t, seq); },
+                [](tagged* p) { delete p; }, corrupted);
+            std::cout << "new/delete " << threads << " threads:\t" << heap_mops << " M ops/s" << std::endl;
+        }
+
+        return 0;
+    }
+}
@@ -1,12 +1,11 @@
 #pragma once
-#include "entity.h"
 #include <iostream>
-#include <chrono>
-#include "Pool.h" // Include your Pool class header file
-
-#include <windows.h>
-static inline std::chrono::time_point<std::chrono::steady_clock> getCurrentTimeMillis();
-
+#include <memory>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "packed_pool.h"
+#include "pool.h"
 
 namespace ecs
 {
@@ -27,62 +26,188 @@ namespace ecs
 
     const int numItems = 100000; // Adjust this as needed
 
+    // Every example times the same thing: create numItems users, then read them 10 times.
+    // Results are per user, median and p99 over the trials. The pools live across trials like they would in a game loop.
+    inline size_t read_users(user* item) {return item->name.size();}
+
     int example_pool()
     {
         // Create an instance of your Pool class
-        ecs::Pool<user> pool((size_t)(numItems*1)); // Replace MyType and BufferSize with actual types and sizes
-
-        std::vector<std::shared_ptr<user>> v;
-        v.reserve(numItems);
-
-        auto startTime = getCurrentTimeMillis();
-        // Allocate items in the pool
-        for (int i = 0; i < numItems; ++i) {
-            v.push_back( pool.MakeSharedPtr("") );
-        }
-
-        for (int i=0;i<10;i++)
-        {
-            // Iterate over the allocated items
-            for (user* item : pool) {
-                printf(item->name.c_str());
-            }
-        }
-        auto endTime = getCurrentTimeMillis();
-
-        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime);
-        std::cout << "Pool test:\t" << duration.count() << " nanoseconds." << std::endl;
-
-        std::cout << "used chunks:\t" << pool.used_chunks() << std::endl;
-
+        ecs::Pool<user> pool((size_t)(numItems*1));
+
+        auto r = bench::run(numItems,
+            [] {
+                std::vector<std::shared_ptr<user>> v;
+                v.reserve(numItems);
+                return v;
+            },
+            [&](auto& v) {
+                // Allocate items in the pool
+                for (int i = 0; i < numItems; ++i) {
+                    v.push_back( pool.MakeSharedPtr("") );
+                }
+                size_t sum = 0;
+                for (int i=0;i<10;i++)
+                {
+                    // Iterate over the allocated items
+                    for (user* item : pool) {
+                        sum += read_users(item);
+                    }
+                }
+                bench::do_not_optimize(sum);
+            },
+            [](auto& v) { v.clear(); });
+        bench::print("shared_ptr", "ecs::Pool", r);
+
+        // Addresses no slab_map leaf covers, another pool's object and our own must all be told apart
+        ecs::Pool<user> other(16);
+        user on_stack;
+        auto on_heap = std::make_unique<user>();
+        user* theirs = other.allocate("");
+        user* ours = pool.allocate("");
+        bool told_apart = !pool.owns(&on_stack) && !pool.owns(on_heap.get()) && !pool.owns(theirs) && pool.owns(ours);
+        pool.deallocate(ours);
+        told_apart = told_apart && !pool.owns(ours);
+        other.deallocate(theirs);
+        std::cout << "foreign pointer:\t" << (told_apart ? "rejected" : "accepted") << std::endl;
+        return told_apart ? 0 : 1;
+    }
 
+    int example_packed_pool()
+    {
+        ecs::PackedPool<user> pool((size_t)(numItems*1));
+
+        auto r = bench::run(numItems,
+            [] {
+                std::vector<ecs::PackedPool<user>::handle> v;
+                v.reserve(numItems);
+                return v;
+            },
+            [&](auto& v) {
+                for (int i = 0; i < numItems; ++i) {
+                    v.push_back( pool.create("") );
+                }
+                size_t sum = 0;
+                for (int i=0;i<10;i++)
+                {
+                    for (user* item : pool) {
+                        sum += read_users(item);
+                    }
+                }
+                bench::do_not_optimize(sum);
+            },
+            [&](auto& v) { for (auto h : v) pool.destroy(h); });
+        bench::print("handles", "ecs::PackedPool", r);
         return 0;
     }
 
-    int example_no_pool()
+    int example_pool_unique()
     {
-        std::vector<std::shared_ptr<user>> v;
-        v.reserve(numItems);
+        ecs::Pool<user> pool((size_t)(numItems*1));
+
+        auto r = bench::run(numItems,
+            [] {
+                std::vector<ecs::Pool<user>::unique_ptr> v;
+                v.reserve(numItems);
+                return v;
+            },
+            [&](auto& v) {
+                // The deleter is stateless so no extra allocation per object
+                for (int i = 0; i < numItems; ++i) {
+                    v.push_back( pool.MakeUniquePtr("") );
+                }
+                size_t sum = 0;
+                for (int i=0;i<10;i++)
+                {
+                    for (auto& item : v) {
+                        sum += read_users(item.get());
+                    }
+                }
+                bench::do_not_optimize(sum);
+            },
+            [](auto& v) { v.clear(); });
+        bench::print("unique_ptr", "ecs::Pool", r);
+        return 0;
+    }
 
-        auto startTime = getCurrentTimeMillis();
-        // Allocate items in the pool
-        for (int i = 0; i < numItems; ++i) {
-            v.push_back( std::make_shared<user>("") );
-        }
-        for (int i=0;i<10;i++)
+    int example_pool_handles()
+    {
+        ecs::Pool<user> pool((size_t)(numItems*1));
+
+        auto r = bench::run(numItems,
+            [] {
+                std::vector<ecs::Pool<user>::handle> v;
+                v.reserve(numItems);
+                return v;
+            },
+            [&](auto& v) {
+                for (int i = 0; i < numItems; ++i) {
+                    v.push_back( pool.create("") );
+                }
+                size_t sum = 0;
+                for (int i=0;i<10;i++)
+                {
+                    // Resolve every handle, each lookup checks the generation
+                    for (auto h : v) {
+                        sum += read_users(pool.get(h));
+                    }
+                }
+                bench::do_not_optimize(sum);
+            },
+            [&](auto& v) { for (auto h : v) pool.destroy(h); });
+        bench::print("handles", "ecs::Pool", r);
+
+        auto h = pool.create("");
+        pool.destroy(h);
+        std::cout << "stale handle:\t" << (pool.get(h) == nullptr ? "detected" : "missed") << std::endl;
+
+        // One slot churns while its slab empties and refills over and over, every 64 cycles the whole slab is
+        // filled. 20000 cycles are far more than the 4095 generations of handle32, but the other slots are only
+        // reused once per fill, so neither the first stale handle nor those of the previous fill may come back.
+        ecs::Pool<int, ecs::handle32> small(64);
+        std::vector<ecs::handle32> all, previous;
+        for (int i=0; i<64; i++) all.push_back(small.create(i));
+        ecs::handle32 stale = all[37];
+        for (auto old : all) small.destroy(old);
+        bool resurrected = false;
+        for (int cycle=0; cycle<20000; cycle++)
         {
-            // Iterate over the allocated items
-            for (auto item : v) {
-                printf(item->name.c_str());
-            }
+            small.destroy(small.create(cycle));
+            if (cycle % 64 != 0) continue;
+            all.clear();
+            for (int i=0; i<64; i++) all.push_back(small.create(i));
+            resurrected = resurrected || small.valid(stale);
+            for (auto old : previous) resurrected = resurrected || small.valid(old);
+            for (auto old : all) small.destroy(old);
+            previous.swap(all);
         }
-        auto endTime = getCurrentTimeMillis();
-
-        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime);
-        std::cout << "No Pool test:\t" << duration.count() << " nanoseconds." << std::endl;
+        std::cout << "stale handle through 20000 refills:\t" << (resurrected ? "missed" : "detected") << std::endl;
+        return resurrected ? 1 : 0;
+    }
 
+    int example_no_pool()
+    {
+        auto r = bench::run(numItems,
+            [] {
+                std::vector<std::shared_ptr<user>> v;
+                v.reserve(numItems);
+                return v;
+            },
+            [](auto& v) {
+                for (int i = 0; i < numItems; ++i) {
+                    v.push_back( std::make_shared<user>("") );
+                }
+                size_t sum = 0;
+                for (int i=0;i<10;i++)
+                {
+                    for (auto& item : v) {
+                        sum += read_users(item.get());
+                    }
+                }
+                bench::do_not_optimize(sum);
+            },
+            [](auto& v) { v.clear(); });
+        bench::print("shared_ptr", "make_shared", r);
         return 0;
     }
 }
-
-
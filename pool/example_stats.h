@@ -0,0 +1,31 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include "pool.h"
+#include "example_churn.h"
+
+namespace ecs
+{
+    // Build with -DECS_POOL_STATS=1 to see the counters, the call sites and the trace file
+    inline int example_stats()
+    {
+        ecs::Pool<particle> pool(1024);
+        pool.trace(4096);
+
+        std::vector<particle*> v;
+        for (int i=0; i<10000; i++) v.push_back(ECS_POOL_ALLOCATE(pool, i));
+        for (int i=0; i<10000; i+=3) pool.deallocate(v[i]);
+        for (int i=0; i<100; i++) pool.allocate(i);
+
+        ecs::pool_snapshot s = pool.stats();
+        std::cout << "used " << s.used << ", capacity " << s.capacity << ", slabs " << s.slabs << ", fragmentation " << s.fragmentation << std::endl;
+        std::cout << "allocations " << s.allocations << ", frees " << s.frees << ", high water " << s.high_water
+                  << ", slabs high water " << s.slabs_high_water << std::endl;
+        pool.visit_sites([](const char* file, uint32_t line, uint64_t count) {
+            std::cout << "  " << (file ? file : "<unknown>") << ":" << line << "\t" << count << std::endl;
+        });
+        if (pool.dump_trace("pool_trace.csv")) std::cout << "trace written to pool_trace.csv" << std::endl;
+
+        return 0;
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "pool.h"
+
+#if defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace ecs
+{
+    // dTLB load misses of this thread through perf_event_open, -1 when perf is unavailable (containers, paranoid level)
+    class tlb_counter
+    {
+        int fd = -1;
+
+    public:
+        tlb_counter()
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+
+        ~tlb_counter() { if (fd >= 0) close(fd); }
+
+        void start()
+        {
+            if (fd < 0) return;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+
+        long long stop()
+        {
+            if (fd < 0) return -1;
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            long long count = 0;
+            if (read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+            return count;
+        }
+    };
+
+    inline long minor_faults()
+    {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_minflt;
+    }
+
+    struct cell
+    {
+        cell(int p_value) : value(p_value) {}
+
+        int value;
+        int padding[7];
+    };
+
+    // Fills a pool with numItems objects and reads them back in random order, which is TLB bound
+    template <class P>
+    inline void run_tlb(const char* name, P& pool)
+    {
+        const size_t numItems = 4000000;
+        std::vector<cell*> v(numItems);
+
+        long faults = minor_faults();
+        auto startTime = std::chrono::steady_clock::now();
+        for (size_t i=0; i<numItems; i++) v[i] = pool.allocate((int)i);
+        auto fillTime = std::chrono::steady_clock::now();
+        long fill_faults = minor_faults() - faults;
+
+        std::mt19937 rng(42);
+        std::shuffle(v.begin(), v.end(), rng);
+
+        tlb_counter tlb;
+        tlb.start();
+        auto readStart = std::chrono::steady_clock::now();
+        long long sum = 0;
+        for (int pass=0; pass<4; pass++)
+        {
+            for (cell* c : v) sum += c->value;
+        }
+        auto readEnd = std::chrono::steady_clock::now();
+        long long misses = tlb.stop();
+
+        for (cell* c : v) pool.deallocate(c);
+
+        std::cout << name << ":\tfill " << std::chrono::duration_cast<std::chrono::milliseconds>(fillTime - startTime).count() << " ms, "
+                  << fill_faults << " page faults, random reads "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(readEnd - readStart).count() << " ms, dTLB misses "
+                  << (misses < 0 ? std::string("n/a") : std::to_string(misses)) << " (sum " << sum << ")" << std::endl;
+    }
+
+    inline int example_tlb()
+    {
+        const size_t slab = 65536;
+        {
+            ecs::Pool<cell> pool(slab);
+            run_tlb("heap slabs", pool);
+        }
+        {
+            ecs::Pool<cell, ecs::handle64, alignof(cell), ecs::mmap_slab_source> pool(slab);
+            run_tlb("mmap slabs", pool);
+        }
+        {
+            ecs::Pool<cell, ecs::handle64, alignof(cell), ecs::mmap_slab_source> pool(slab, ecs::mmap_slab_source(ecs::mmap_slab_source::transparent_huge_pages));
+            run_tlb("mmap THP", pool);
+        }
+        {
+            ecs::Pool<cell, ecs::handle64, alignof(cell), ecs::mmap_slab_source> pool(slab, ecs::mmap_slab_source(ecs::mmap_slab_source::transparent_huge_pages | ecs::mmap_slab_source::populate));
+            run_tlb("mmap THP+populate", pool);
+        }
+        {
+            ecs::Pool<cell, ecs::handle64, alignof(cell), ecs::mmap_slab_source> pool(slab, ecs::mmap_slab_source(ecs::mmap_slab_source::huge_tlb));
+            run_tlb("mmap hugetlb", pool);
+        }
+        return 0;
+    }
+}
+#else
+namespace ecs
+{
+    inline int example_tlb() { return 0; }
+}
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace ecs
+{
+    // Index + generation packed in one word. A slot bumps its generation every time it is freed,
+    // so a handle to a destroyed object no longer matches and is detected as stale.
+    // Generation 0 is never used, which makes the all-zero value the null handle.
+    template <class Word, unsigned IndexBits>
+    struct basic_handle
+    {
+        static_assert(std::numeric_limits<Word>::is_integer && !std::numeric_limits<Word>::is_signed, "handle word must be unsigned");
+        static_assert(IndexBits > 0 && IndexBits < sizeof(Word)*8, "handle needs both index and generation bits");
+
+        using word = Word;
+        static constexpr unsigned index_bits      = IndexBits;
+        static constexpr unsigned generation_bits = sizeof(Word)*8 - IndexBits;
+        static constexpr Word     index_mask      = (Word(1) << IndexBits) - 1;
+        static constexpr Word     generation_mask = Word(~Word(0)) >> IndexBits;
+        static constexpr Word     max_index       = index_mask;
+
+        Word value = 0;
+
+        constexpr basic_handle() = default;
+        constexpr basic_handle(Word index, Word generation) : value((generation & generation_mask) << IndexBits | (index & index_mask)) {}
+
+        constexpr Word index() const {return value & index_mask;}
+        constexpr Word generation() const {return value >> IndexBits;}
+
+        // Next generation for a slot, skipping 0 on wrap-around
+        static constexpr Word next_generation(Word generation)
+        {
+            generation = (generation + 1) & generation_mask;
+            return generation ? generation : 1;
+        }
+
+        constexpr explicit operator bool() const {return value != 0;}
+        constexpr bool operator==(const basic_handle& other) const {return value == other.value;}
+        constexpr bool operator!=(const basic_handle& other) const {return value != other.value;}
+    };
+
+    using handle32 = basic_handle<uint32_t, 20>; // 1M slots, 4095 generations
+    using handle64 = basic_handle<uint64_t, 32>; // 4G slots, 4G generations
+}
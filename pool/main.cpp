@@ -1,12 +1,23 @@
 #include "example_pool.h"
-
-static inline std::chrono::time_point<std::chrono::steady_clock> getCurrentTimeMillis() {
-    return std::chrono::steady_clock::now();
-}
+#include "example_churn.h"
+#include "example_concurrent.h"
+#include "example_tlb.h"
+#include "example_batch.h"
+#include "example_stats.h"
 
 int main()
 {
+    bench::print_header();
     ecs::example_pool();
+    ecs::example_packed_pool();
+    ecs::example_pool_unique();
+    ecs::example_pool_handles();
     ecs::example_no_pool();
+    ecs::example_churn();
+    ecs::example_spike();
+    ecs::example_concurrent();
+    ecs::example_tlb();
+    ecs::example_batch();
+    ecs::example_stats();
     return 0;
 }
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include "handle.h"
+
+namespace ecs
+{
+    // Keeps live objects dense in one contiguous array. Removing an object moves the last one into the hole,
+    // so objects are addressed through stable handles that go through an indirection table.
+    template <class T, class Handle = handle64>
+    class PackedPool
+    {
+    public:
+        using handle = Handle;
+
+    private:
+        static constexpr uint32_t no_entry = UINT32_MAX;
+
+        struct entry
+        {
+            uint32_t dense;         // index in m_dense, or next free entry while unused
+            uint32_t generation;
+        };
+
+        std::vector<T>          m_dense;            // live objects, no holes
+        std::vector<uint32_t>   m_dense_to_entry;   // entry owning each dense slot
+        std::vector<entry>      m_sparse;           // indirection table addressed by handle index
+        uint32_t                m_free = no_entry;
+
+        entry* entry_of(handle h)
+        {
+            size_t i = (size_t)h.index();
+            if (!h || i >= m_sparse.size()) return nullptr;
+            entry& e = m_sparse[i];
+            if (e.generation != h.generation() || e.dense >= m_dense.size() || m_dense_to_entry[e.dense] != i) return nullptr;
+            return &e;
+        }
+
+    public:
+        PackedPool(size_t reserve = 0)
+        {
+            m_dense.reserve(reserve);
+            m_dense_to_entry.reserve(reserve);
+            m_sparse.reserve(reserve);
+        }
+
+        size_t free_chunks() {return m_dense.capacity() - m_dense.size();}
+        size_t used_chunks() {return m_dense.size();}
+
+        template<typename... Args>
+        handle create(Args&&... args)
+        {
+            if (m_free == no_entry && (m_sparse.size() > Handle::max_index || m_sparse.size() >= no_entry))
+                throw std::length_error("ecs::PackedPool: too many objects for the handle type");
+            m_dense.emplace_back(std::forward<Args>(args)...);
+
+            uint32_t i;
+            if (m_free != no_entry)
+            {
+                i = m_free;
+                m_free = m_sparse[i].dense;
+            }
+            else
+            {
+                i = (uint32_t)m_sparse.size();
+                m_sparse.push_back({0, 1});
+            }
+            m_sparse[i].dense = (uint32_t)(m_dense.size()-1);
+            m_dense_to_entry.push_back(i);
+            return handle(i, m_sparse[i].generation);
+        }
+
+        // Destroys the object behind h. Returns false if the handle is null or stale.
+        bool destroy(handle h)
+        {
+            entry* e = entry_of(h);
+            if (!e) return false;
+            uint32_t hole = e->dense;
+            uint32_t last = (uint32_t)(m_dense.size()-1);
+            if (hole != last)
+            {
+                // swap-and-pop: the last object fills the hole and its handle is patched
+                m_dense[hole] = std::move(m_dense[last]);
+                m_dense_to_entry[hole] = m_dense_to_entry[last];
+                m_sparse[m_dense_to_entry[hole]].dense = hole;
+            }
+            m_dense.pop_back();
+            m_dense_to_entry.pop_back();
+
+            e->generation = (uint32_t)Handle::next_generation(e->generation);
+            e->dense = m_free;
+            m_free = (uint32_t)h.index();
+            return true;
+        }
+
+        // O(1) lookup, nullptr if the handle is null or stale.
+        // Pointers are only valid until the next create or destroy, keep handles instead.
+        T* get(handle h)
+        {
+            entry* e = entry_of(h);
+            return e ? &m_dense[e->dense] : nullptr;
+        }
+
+        bool valid(handle h) {return entry_of(h) != nullptr;}
+
+        T*     data() {return m_dense.data();}
+        size_t size() const {return m_dense.size();}
+
+        // Iterator over the dense array. Yields T* so it can be used like ecs::Pool.
+        class iterator
+        {
+        private:
+            T* it;
+
+        public:
+            iterator(T* it) : it(it) {}
+
+            T* operator*() const {
+                return it;
+            }
+
+            iterator& operator++() {
+                ++it;
+                return *this;
+            }
+
+            bool operator==(const iterator& other) const {
+                return it == other.it;
+            }
+
+            bool operator!=(const iterator& other) const {
+                return !(*this == other);
+            }
+        };
+
+        iterator begin() {
+            return iterator(m_dense.data());
+        }
+
+        iterator end() {
+            return iterator(m_dense.data() + m_dense.size());
+        }
+    };
+}
@@ -1,86 +1,506 @@
 #pragma once
 
-#include <deque>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <new>
+#include <span>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <cassert>
-#include <algorithm>
+#include "handle.h"
+#include "pool_stats.h"
+#include "slab_map.h"
+#include "slab_source.h"
 
 namespace ecs
 {
-    template <class T>
+    // Alignment presets for Pool. 64 covers a cache line and a full AVX-512 register.
+    constexpr size_t cache_line_align = 64;
+    constexpr size_t simd_align       = 64;
+
+    // Align raises the alignment of every object above alignof(T). The slot stride is sizeof(T) padded to it,
+    // so no object straddles a cache line and aligned SIMD loads are valid on every slot. The per slot
+    // bookkeeping lives in a parallel array after the slots and the slab is found through slab_map, so it
+    // adds nothing to the stride.
+    // Source provides the slab memory (see slab_source.h). When it can decommit, the pages of a slab
+    // that becomes empty are handed back to the OS unless the pool is currently allocating from it.
+    template <class T, class Handle = handle64, size_t Align = alignof(T), class Source = heap_slab_source>
     class Pool
     {
+    public:
+        using handle = Handle;
+        static constexpr size_t alignment = Align > alignof(T) ? Align : alignof(T);
+
+        // Stateless deleter: the owning pool is found from the slab header of the object
+        struct deleter
+        {
+            void operator()(T* ptr) const
+            {
+                owner_of(ptr)->deallocate(ptr);
+            }
+        };
+
+        using unique_ptr = std::unique_ptr<T, deleter>;
+
     private:
+        static_assert(Handle::generation_bits <= 32, "slot generations are 32 bit");
+        static_assert((Align & (Align-1)) == 0, "alignment must be a power of two");
 
-        size_t m_buffer_size;
-        std::deque<std::vector<std::byte>> buffers;
-        std::deque<std::byte*> freeChunks; // List of free chunks within each buffer
-        std::deque<std::byte*> usedChunks; // List of used chunks within each buffer
+        struct alignas(alignment) slot
+        {
+            // While the slot is free the storage is reused as the link to the next free slot
+            union
+            {
+                alignas(alignment) std::byte storage[sizeof(T)];
+                slot* next_free;
+            };
+
+            T* object() { return std::launder(reinterpret_cast<T*>(storage)); }
+        };
 
-        void emplace_new_buffer()
+        struct slot_meta
         {
-            buffers.emplace_back().resize(m_buffer_size);
-            for (std::byte* p=&buffers.back()[0] ; p<&buffers.back()[buffers.back().size()-1] ; p+=sizeof(T))
+            uint32_t generation;
+            bool     live;
+        };
+
+        // Slab header, the slots and then their slot_meta follow it in the same allocation
+        struct slab
+        {
+            Pool*      owner = nullptr;
+            slot_meta* meta = nullptr;
+            slot*      free = nullptr;  // intrusive free list of released slots
+            uint32_t bump = 0;          // slots [bump, capacity) were never handed out
+            uint32_t live = 0;
+            uint32_t id   = 0;
+            uint32_t last_generation = 0;   // newest generation of any slot, a slab reusing the id starts past it
+            slab*    prev_partial = nullptr;
+            slab*    next_partial = nullptr;
+            bool     partial      = false;
+
+            slot* slots() { return reinterpret_cast<slot*>(reinterpret_cast<std::byte*>(this) + header_size); }
+            uint32_t index_of(slot* sl) { return (uint32_t)(sl - slots()); }
+        };
+
+        // Page aligned so slab_map can tell the slabs apart
+        static constexpr size_t slab_align  = std::max({alignof(slab), alignof(slot), slab_map::page_size});
+        static constexpr size_t header_size = (sizeof(slab) + alignof(slot) - 1) / alignof(slot) * alignof(slot);
+
+        Source              m_source;
+        uint32_t            m_slab_capacity;
+        size_t              m_used = 0;
+        std::vector<slab*>  m_slabs;            // indexed by slab id, nullptr once a slab is released
+        size_t              m_slab_count = 0;   // slabs currently held
+        slab*               m_partial = nullptr; // slabs with at least one free slot
+
+        // Ids of released slabs with the generation a new slab must start after
+        std::vector<std::pair<uint32_t, uint32_t>> m_released_ids;
+
+        [[no_unique_address]] default_pool_stats m_stats;
+
+        static slot* slot_of(T* ptr) {return reinterpret_cast<slot*>(ptr);}
+
+        static slab* slab_of(const void* ptr) {return static_cast<slab*>(slab_map::find(ptr));}
+
+        static Pool* owner_of(T* ptr) {return slab_of(ptr)->owner;}
+
+        slot* slot_of(handle h) const
+        {
+            size_t index = (size_t)h.index();
+            size_t slab_id = index / m_slab_capacity;
+            if (!h || slab_id >= m_slabs.size() || !m_slabs[slab_id]) return nullptr;
+            slab* s = m_slabs[slab_id];
+            uint32_t i = (uint32_t)(index % m_slab_capacity);
+            if (i >= s->bump) return nullptr;
+            return (s->meta[i].live && s->meta[i].generation == h.generation()) ? s->slots() + i : nullptr;
+        }
+
+        size_t meta_offset() const { return header_size + sizeof(slot)*m_slab_capacity; }
+        size_t slab_bytes() const { return meta_offset() + sizeof(slot_meta)*m_slab_capacity; }
+
+        slab* emplace_new_slab()
+        {
+            if (m_released_ids.empty() && (m_slabs.size() >= UINT32_MAX || (m_slabs.size()+1)*m_slab_capacity-1 > Handle::max_index))
+                throw std::length_error("ecs::Pool: too many slabs for the handle type");
+            void* memory = m_source.acquire(slab_bytes(), slab_align);
+            try
             {
-                freeChunks.push_back(p);
+                slab_map::insert(memory, slab_bytes(), memory);
             }
+            catch (...)
+            {
+                m_source.release(memory, slab_bytes(), slab_align);
+                throw;
+            }
+            slab* s = new (memory) slab();
+            s->owner = this;
+            s->meta = reinterpret_cast<slot_meta*>(static_cast<std::byte*>(memory) + meta_offset());
+            if (!m_released_ids.empty())
+            {
+                // Reuse a released id, its handles stay stale because generations continue where they stopped
+                s->id = m_released_ids.back().first;
+                s->last_generation = m_released_ids.back().second;
+                m_released_ids.pop_back();
+                m_slabs[s->id] = s;
+            }
+            else
+            {
+                s->id = (uint32_t)m_slabs.size();
+                m_slabs.push_back(s);
+            }
+            uint32_t generation = (uint32_t)Handle::next_generation(s->last_generation);
+            for (uint32_t i=0; i<m_slab_capacity; i++) new (s->meta + i) slot_meta{generation, false};
+            ++m_slab_count;
+            m_stats.on_slab(1);
+            link_partial(s);
+            return s;
         }
 
+        // Returns an empty slab to the source
+        void release_slab(slab* s)
+        {
+            assert(s->live == 0);
+            if (s->partial) unlink_partial(s);
+            m_released_ids.emplace_back(s->id, s->last_generation);
+            m_slabs[s->id] = nullptr;
+            --m_slab_count;
+            m_stats.on_slab(-1);
+            s->~slab();
+            slab_map::erase(s, slab_bytes());
+            m_source.release(s, slab_bytes(), slab_align);
+        }
+
+        void link_partial(slab* s)
+        {
+            s->prev_partial = nullptr;
+            s->next_partial = m_partial;
+            if (m_partial) m_partial->prev_partial = s;
+            m_partial = s;
+            s->partial = true;
+        }
+
+        void unlink_partial(slab* s)
+        {
+            if (s->prev_partial) s->prev_partial->next_partial = s->next_partial;
+            else m_partial = s->next_partial;
+            if (s->next_partial) s->next_partial->prev_partial = s->prev_partial;
+            s->prev_partial = s->next_partial = nullptr;
+            s->partial = false;
+        }
+
+        // Pops a free slot in O(1): the slab free list first, then the untouched tail of the slab
+        slot* acquire_slot()
+        {
+            slab* s = m_partial ? m_partial : emplace_new_slab();
+            slot* sl;
+            if (s->free)
+            {
+                sl = s->free;
+                s->free = sl->next_free;
+            }
+            else
+            {
+                sl = s->slots() + s->bump++;
+            }
+            if (++s->live == m_slab_capacity) unlink_partial(s);
+            return sl;
+        }
+
+        // Fills out[0, n) with the storage of free slots. Untouched slab tails are handed out as contiguous runs and the
+        // slab counters are updated once per slab instead of once per slot. Takes nothing when a new slab cannot be made.
+        void acquire_slots(T** out, size_t n)
+        {
+            size_t done = 0;
+            while (done < n)
+            {
+                slab* s = m_partial;
+                if (!s)
+                {
+                    try
+                    {
+                        s = emplace_new_slab();
+                    }
+                    catch (...)
+                    {
+                        for (size_t k=0; k<done; k++) release_slot(slot_of(out[k]));
+                        throw;
+                    }
+                }
+                uint32_t taken = 0;
+                while (s->free && done < n)
+                {
+                    out[done++] = reinterpret_cast<T*>(s->free->storage);
+                    s->free = s->free->next_free;
+                    ++taken;
+                }
+                uint32_t run = (uint32_t)std::min<size_t>(n - done, m_slab_capacity - s->bump);
+                slot* first = s->slots() + s->bump;
+                for (uint32_t i=0; i<run; i++) out[done++] = reinterpret_cast<T*>(first[i].storage);
+                s->bump += run;
+                s->live += taken + run;
+                if (s->live == m_slab_capacity) unlink_partial(s);
+            }
+        }
+
+        void release_slot(slot* sl)
+        {
+            slab* s = slab_of(sl);
+            slot_meta& meta = s->meta[s->index_of(sl)];
+            meta.live = false;
+            meta.generation = (uint32_t)Handle::next_generation(meta.generation);
+            if (meta.generation > s->last_generation) s->last_generation = meta.generation;
+            sl->next_free = s->free;
+            s->free = sl;
+            if (s->live-- == m_slab_capacity) link_partial(s);
+            if (s->live == 0) rewind(s);
+        }
+
+        // An empty slab drops its free list and restarts from its bump region, so the next allocations
+        // are contiguous again. Every slot keeps its own generation in the slot metadata, so old handles stay
+        // stale and the churn of one slot does not age the others.
+        // When the source can decommit, the slot pages are also given back to the OS unless the pool
+        // is currently allocating from this slab.
+        void rewind(slab* s)
+        {
+            s->free = nullptr;
+            s->bump = 0;
+            if constexpr (Source::can_decommit)
+            {
+                if (s != m_partial) m_source.decommit(s->slots(), s->slots() + m_slab_capacity);
+            }
+        }
 
     public:
-        Pool(size_t buffer_size) {
-            m_buffer_size = buffer_size;
+        // buffer_size is the number of objects held by each slab
+        Pool(size_t buffer_size, Source source = Source()) : m_source(std::move(source))
+        {
+            if (buffer_size == 0 || buffer_size > UINT32_MAX) throw std::invalid_argument("ecs::Pool: invalid buffer size");
+            m_slab_capacity = (uint32_t)buffer_size;
             // Ensure there is at least one buffer available
-            emplace_new_buffer();
+            emplace_new_slab();
+        }
+
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        ~Pool()
+        {
+            for (slab* s : m_slabs)
+            {
+                if (!s) continue;
+                for (uint32_t i=0; i<s->bump; i++)
+                {
+                    if (s->meta[i].live) s->slots()[i].object()->~T();
+                }
+                s->~slab();
+                slab_map::erase(s, slab_bytes());
+                m_source.release(s, slab_bytes(), slab_align);
+            }
+        }
+
+        // All counts are in objects
+        size_t free_chunks() {return capacity() - m_used;}
+        size_t used_chunks() {return m_used;}
+        size_t capacity() const {return m_slab_count*m_slab_capacity;}
+        size_t slab_capacity() const {return m_slab_capacity;}
+        size_t slab_count() const {return m_slab_count;}
+        double occupancy() const {return m_slab_count ? (double)m_used/capacity() : 0.0;}
+
+        // Occupancy figures plus the ECS_POOL_STATS counters. Walks the slab table.
+        pool_snapshot stats() const
+        {
+            pool_snapshot snapshot;
+            snapshot.used = m_used;
+            snapshot.capacity = capacity();
+            snapshot.slabs = m_slab_count;
+            size_t stranded = 0;
+            for (slab* s : m_slabs)
+            {
+                if (s && s->live > 0) stranded += m_slab_capacity - s->live;
+            }
+            snapshot.fragmentation = snapshot.capacity ? (double)stranded/snapshot.capacity : 0.0;
+            m_stats.fill(snapshot);
+            return snapshot;
         }
 
-        size_t free_chunks() {return freeChunks.size();}
-        size_t used_chunks() {return usedChunks.size();}
+        // Tracing and per-site counts, no-ops unless ECS_POOL_STATS is on
+        void trace(size_t capacity) {m_stats.trace(capacity);}
+        bool dump_trace(const char* path) const {return m_stats.dump_trace(path);}
+        template <class Visit>
+        void visit_sites(Visit&& visit) const {m_stats.visit_sites(std::forward<Visit>(visit));}
+
+        // Releases empty slabs while more than `threshold` free objects would remain.
+        // Returns the number of slabs released.
+        size_t trim(size_t threshold)
+        {
+            size_t released = 0;
+            for (slab* s : m_slabs)
+            {
+                if (!s || s->live != 0) continue;
+                if (free_chunks() < threshold + m_slab_capacity) break;
+                release_slab(s);
+                ++released;
+            }
+            return released;
+        }
+
+        // Releases every empty slab
+        size_t shrink_to_fit() {return trim(0);}
+
+        // Moves the objects of sparse slabs (occupancy <= max_occupancy) into the free slots of denser ones,
+        // then releases the emptied slabs. Every move invokes relocate(old_handle, new_handle, T* object) so
+        // callers can patch handles and pointers. Slabs are only evacuated when the remaining slabs can hold
+        // their objects, so compaction never grows the pool. Returns the number of objects moved.
+        template <class Relocate>
+        size_t compact(double max_occupancy, Relocate&& relocate)
+        {
+            static_assert(std::is_nothrow_move_constructible<T>::value, "ecs::Pool::compact needs a nothrow movable T");
+            if (max_occupancy >= 1.0) max_occupancy = (double)(m_slab_capacity-1)/m_slab_capacity;
+
+            std::vector<slab*> sources;
+            size_t destination_free = 0;
+            for (slab* s : m_slabs)
+            {
+                if (!s) continue;
+                destination_free += m_slab_capacity - s->live;
+                if (s->live > 0 && s->live <= max_occupancy*m_slab_capacity) sources.push_back(s);
+            }
+            // Sparsest slabs first, they are the cheapest to empty
+            std::sort(sources.begin(), sources.end(), [](slab* a, slab* b) {return a->live < b->live;});
+
+            size_t selected = 0;
+            for (slab* s : sources)
+            {
+                size_t remaining = destination_free - (m_slab_capacity - s->live);
+                if (s->live > remaining) break;
+                destination_free = remaining - s->live;
+                // Take it off the partial list so nothing is allocated into it while it is evacuated
+                if (s->partial) unlink_partial(s);
+                ++selected;
+            }
+            sources.resize(selected);
 
-        // Method to allocate memory for a new object and return a shared pointer
+            size_t moved = 0;
+            for (slab* s : sources)
+            {
+                for (uint32_t i=0; i<s->bump && s->live>0; i++)
+                {
+                    slot* from = s->slots() + i;
+                    if (!s->meta[i].live) continue;
+                    handle old_handle = handle_of(from->object());
+
+                    slot* to = acquire_slot();
+                    new (to->storage) T(std::move(*from->object()));
+                    set_live(to);
+                    from->object()->~T();
+                    release_slot(from);
+
+                    relocate(old_handle, handle_of(to->object()), to->object());
+                    ++moved;
+                }
+                release_slab(s);
+            }
+            return moved;
+        }
+
+        // Method to allocate memory for a new object and return a shared pointer.
+        // The shared_ptr control block is still a separate heap allocation, prefer handles or MakeUniquePtr.
         template<typename... Args>
         std::shared_ptr<T> MakeSharedPtr(Args&&... args)
         {
-            T* ptr = allocate(std::forward<Args>(args)...);
-            return std::shared_ptr<T>(ptr, [this](T* ptr) {
-                deallocate(ptr);
-            });
+            return std::shared_ptr<T>(allocate(std::forward<Args>(args)...), deleter());
         }
 
-        // Method to allocate memory for a new object and return a unique pointer
+        // Method to allocate memory for a new object and return a unique pointer, same size as T*
         template<typename... Args>
-        std::unique_ptr<T> MakeUniquePtr(Args&&... args)
+        unique_ptr MakeUniquePtr(Args&&... args)
         {
-            T* ptr = allocate(std::forward<Args>(args)...);
-            return std::unique_ptr<T>(ptr, [this](T* ptr) {
-                deallocate(ptr);
-            });
+            return unique_ptr(allocate(std::forward<Args>(args)...));
         }
 
-        // Iterator class to iterate over used chunks
+        // Allocates a new object and returns its generational handle
+        template<typename... Args>
+        handle create(Args&&... args)
+        {
+            return handle_of(allocate(std::forward<Args>(args)...));
+        }
+
+        // Destroys the object behind h. Returns false if the handle is null or stale.
+        bool destroy(handle h)
+        {
+            slot* sl = slot_of(h);
+            if (!sl) return false;
+            deallocate(sl->object());
+            return true;
+        }
+
+        // O(1) lookup, nullptr if the handle is null or stale
+        T* get(handle h) const
+        {
+            slot* sl = slot_of(h);
+            return sl ? sl->object() : nullptr;
+        }
+
+        bool valid(handle h) const {return slot_of(h) != nullptr;}
+
+        // True for a live object of this pool, false for any other address
+        bool owns(const T* ptr) const {return owns(slot_of(const_cast<T*>(ptr)));}
+
+        // Handle of a live object owned by this pool
+        handle handle_of(T* ptr) const
+        {
+            slab* s = slab_of(ptr);
+            uint32_t i = s->index_of(slot_of(ptr));
+            return handle((typename Handle::word)s->id*m_slab_capacity + i, s->meta[i].generation);
+        }
+
+        // Iterator class to iterate over used chunks, slab by slab in address order
         class iterator
         {
         private:
-            using ChunkIterator = typename std::deque<std::byte*>::iterator;
+            const std::vector<slab*>* slabs;
+            size_t   slab_index;
+            uint32_t slot_index;
 
-            ChunkIterator chunkIt;
+            void skip_free()
+            {
+                while (slab_index < slabs->size())
+                {
+                    slab* s = (*slabs)[slab_index];
+                    if (!s)
+                    {
+                        ++slab_index;
+                        continue;
+                    }
+                    while (slot_index < s->bump && !s->meta[slot_index].live) ++slot_index;
+                    if (slot_index < s->bump) return;
+                    ++slab_index;
+                    slot_index = 0;
+                }
+            }
 
         public:
-            iterator(ChunkIterator chunkIt) : chunkIt(chunkIt) {}
+            iterator(const std::vector<slab*>* slabs, size_t slab_index) : slabs(slabs), slab_index(slab_index), slot_index(0)
+            {
+                skip_free();
+            }
 
             T* operator*() const {
-                return reinterpret_cast<T*>((*chunkIt));
+                return (*slabs)[slab_index]->slots()[slot_index].object();
             }
 
             iterator& operator++() {
-                ++chunkIt;
+                ++slot_index;
+                skip_free();
                 return *this;
             }
 
             bool operator==(const iterator& other) const {
-                return chunkIt == other.chunkIt;
+                return slab_index == other.slab_index && slot_index == other.slot_index;
             }
 
             bool operator!=(const iterator& other) const {
@@ -89,62 +509,127 @@ namespace ecs
         };
 
         iterator begin() {
-            return iterator(usedChunks.begin());
+            return iterator(&m_slabs, 0);
         }
 
         iterator end() {
-            return iterator(usedChunks.end());
+            return iterator(&m_slabs, m_slabs.size());
         }
 
-    private:
         // Method to allocate memory for a new object
         template<typename... Args>
         T* allocate(Args&&... args)
         {
-            if (freeChunks.empty())
+            return construct(nullptr, std::forward<Args>(args)...);
+        }
+
+        // Same as allocate, also records the call site when ECS_POOL_STATS is on (see ECS_POOL_ALLOCATE)
+        template<typename... Args>
+        T* allocate_at(const std::source_location& site, Args&&... args)
+        {
+            return construct(&site, std::forward<Args>(args)...);
+        }
+
+    private:
+        static void set_live(slot* sl)
+        {
+            slab* s = slab_of(sl);
+            s->meta[s->index_of(sl)].live = true;
+        }
+
+        bool owns(slot* sl) const
+        {
+            slab* s = slab_of(sl);
+            if (!s || s->owner != this) return false;
+            // a stray pointer may still land in one of our headers or between two slots
+            std::ptrdiff_t offset = reinterpret_cast<std::byte*>(sl) - reinterpret_cast<std::byte*>(s->slots());
+            if (offset < 0 || offset % sizeof(slot) != 0 || size_t(offset) / sizeof(slot) >= m_slab_capacity) return false;
+            return s->meta[offset / sizeof(slot)].live;
+        }
+
+        template<typename... Args>
+        T* construct(const std::source_location* site, Args&&... args)
+        {
+            slot* sl = acquire_slot();
+            try
             {
-                // No free chunks available, allocate a new buffer
-                emplace_new_buffer();
+                new (sl->storage) T(std::forward<Args>(args)...);
             }
-            for (size_t i = 0; i < buffers.size(); ++i)
+            catch (...)
             {
-                if (!freeChunks.empty())
-                {
-                    std::byte* chunk = freeChunks.back();
-                    freeChunks.pop_back();
-                    usedChunks.push_back(chunk);
-                    return new (chunk) T(std::forward<Args>(args)...);
-                }
+                release_slot(sl);
+                throw;
             }
-            assert(false);
-            return {};
+            set_live(sl);
+            ++m_used;
+            m_stats.on_allocate(sl->storage, 1, site);
+            return sl->object();
         }
 
-        // Method to deallocate memory for an object
+    public:
+        // Method to deallocate memory for an object. The object must belong to this pool.
         void deallocate(T* ptr)
         {
-            // Find the buffer containing the memory chunk
-            for (size_t i = 0; i < buffers.size(); ++i) {
-                auto& buffer = buffers[i];
-                size_t buffsize = m_buffer_size*sizeof(T);
-                if (reinterpret_cast<std::byte*>(ptr) >= reinterpret_cast<std::byte*>(&buffer[0]) &&
-                    reinterpret_cast<std::byte*>(ptr) < reinterpret_cast<std::byte*>(&buffer[buffsize]))
-                {
-                    // Call destructor
-                    ptr->~T();
-                    // Add the memory chunk to the free list of the buffer
-                    freeChunks.push_back((std::byte*)ptr);
-
-                    std::byte* ptrToRemove = (std::byte*)ptr;
-                    auto it = std::find_if(usedChunks.begin(), usedChunks.end(),
-                                           [ptrToRemove](std::byte* ptr) { return ptr == ptrToRemove; });
-                    if (it != usedChunks.end()) {
-                        usedChunks.erase(it); // Remove the pointer from the deque
-                    }
+            // The object lives at the start of its slot, so the slot header is found without searching
+            slot* sl = slot_of(ptr);
+            assert(owns(sl) && "ecs::Pool: pointer not owned by this pool");
+            ptr->~T();
+            release_slot(sl);
+            --m_used;
+            m_stats.on_free(ptr, 1);
+        }
 
-                    return;
+        // Allocates out.size() objects in one go and stores their addresses in out.
+        // Each object is built from init(i), which must return a T (it is constructed in place).
+        template<typename Init>
+        void allocate_n(std::span<T*> out, Init&& init)
+        {
+            acquire_slots(out.data(), out.size());
+            size_t i = 0;
+            try
+            {
+                for (; i<out.size(); i++)
+                {
+                    slot* sl = slot_of(out[i]);
+                    new (sl->storage) T(init(i));
+                    set_live(sl);
+                    out[i] = sl->object();
                 }
             }
+            catch (...)
+            {
+                for (size_t k=0; k<out.size(); k++)
+                {
+                    if (k < i) out[k]->~T();
+                    release_slot(slot_of(out[k]));
+                }
+                throw;
+            }
+            m_used += out.size();
+            m_stats.on_allocate(out.empty() ? nullptr : out[0], out.size(), nullptr);
+        }
+
+        // Default-constructs out.size() objects
+        void allocate_n(std::span<T*> out)
+        {
+            allocate_n(out, [](size_t) {return T();});
+        }
+
+        // Destroys and frees every object in objects, all must belong to this pool
+        void free_n(std::span<T* const> objects)
+        {
+            for (T* ptr : objects)
+            {
+                slot* sl = slot_of(ptr);
+                assert(owns(sl) && "ecs::Pool: pointer not owned by this pool");
+                ptr->~T();
+                release_slot(sl);
+            }
+            m_used -= objects.size();
+            m_stats.on_free(objects.empty() ? nullptr : objects[0], objects.size());
         }
     };
+
+    template <class T, size_t Align>
+    using AlignedPool = Pool<T, handle64, Align>;
 }
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <source_location>
+#include <unordered_map>
+#include <vector>
+
+// Define ECS_POOL_STATS=1 to compile the instrumentation into ecs::Pool. With the default of 0 every hook
+// is an empty inline function on an empty member, so nothing is left in the generated code.
+#ifndef ECS_POOL_STATS
+#define ECS_POOL_STATS 0
+#endif
+
+// Allocates from a pool and records the call site in the per-site histogram
+#define ECS_POOL_ALLOCATE(pool, ...) (pool).allocate_at(std::source_location::current() __VA_OPT__(,) __VA_ARGS__)
+
+namespace ecs
+{
+    struct pool_snapshot
+    {
+        // Always available, computed from the pool itself
+        size_t used = 0;
+        size_t capacity = 0;
+        size_t slabs = 0;
+        double fragmentation = 0;   // free slots stranded in slabs that still hold objects, over capacity
+
+        // Only counted with ECS_POOL_STATS
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        size_t   high_water = 0;
+        size_t   slabs_high_water = 0;
+    };
+
+    struct pool_event
+    {
+        enum kind : uint8_t { allocate, free };
+
+        uint64_t    nanoseconds;
+        const void* address;
+        const char* file;   // nullptr when the call site is unknown
+        uint32_t    line;
+        kind        op;
+    };
+
+    // Instrumentation used when ECS_POOL_STATS is 1
+    class pool_stats
+    {
+    private:
+        struct site_key
+        {
+            const char* file;
+            uint32_t    line;
+            bool operator==(const site_key& other) const {return file == other.file && line == other.line;}
+        };
+
+        struct site_hash
+        {
+            size_t operator()(const site_key& key) const {return std::hash<const void*>()(key.file) ^ (size_t(key.line) * 0x9e3779b97f4a7c15ull);}
+        };
+
+        uint64_t m_allocations = 0;
+        uint64_t m_frees = 0;
+        size_t   m_live = 0;
+        size_t   m_high_water = 0;
+        size_t   m_slabs = 0;
+        size_t   m_slabs_high_water = 0;
+        std::unordered_map<site_key, uint64_t, site_hash> m_sites;
+
+        std::vector<pool_event> m_trace;    // ring buffer, empty while tracing is off
+        size_t m_trace_next = 0;
+        bool   m_trace_wrapped = false;
+        std::chrono::steady_clock::time_point m_epoch = std::chrono::steady_clock::now();
+
+        void record(pool_event::kind op, const void* address, const char* file, uint32_t line)
+        {
+            if (m_trace.empty()) return;
+            uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count();
+            m_trace[m_trace_next] = {ns, address, file, line, op};
+            if (++m_trace_next == m_trace.size())
+            {
+                m_trace_next = 0;
+                m_trace_wrapped = true;
+            }
+        }
+
+    public:
+        void on_allocate(const void* address, size_t count, const std::source_location* site)
+        {
+            m_allocations += count;
+            m_live += count;
+            if (m_live > m_high_water) m_high_water = m_live;
+            const char* file = site ? site->file_name() : nullptr;
+            uint32_t line = site ? (uint32_t)site->line() : 0;
+            m_sites[{file, line}] += count;
+            record(pool_event::allocate, address, file, line);
+        }
+
+        void on_free(const void* address, size_t count)
+        {
+            m_frees += count;
+            m_live -= count;
+            record(pool_event::free, address, nullptr, 0);
+        }
+
+        void on_slab(int delta)
+        {
+            m_slabs += delta;
+            if (m_slabs > m_slabs_high_water) m_slabs_high_water = m_slabs;
+        }
+
+        void fill(pool_snapshot& snapshot) const
+        {
+            snapshot.allocations = m_allocations;
+            snapshot.frees = m_frees;
+            snapshot.high_water = m_high_water;
+            snapshot.slabs_high_water = m_slabs_high_water;
+        }
+
+        // Starts recording the last `capacity` events, 0 stops tracing
+        void trace(size_t capacity)
+        {
+            m_trace.assign(capacity, pool_event{});
+            m_trace_next = 0;
+            m_trace_wrapped = false;
+        }
+
+        // Allocation count per call site, sites reached through plain allocate() have a null file
+        template <class Visit>
+        void visit_sites(Visit&& visit) const
+        {
+            for (auto& site : m_sites) visit(site.first.file, site.first.line, site.second);
+        }
+
+        // Writes the trace oldest first as CSV: ns,op,address,file,line
+        bool dump_trace(const char* path) const
+        {
+            FILE* f = std::fopen(path, "w");
+            if (!f) return false;
+            std::fprintf(f, "ns,op,address,file,line\n");
+            size_t count = m_trace_wrapped ? m_trace.size() : m_trace_next;
+            size_t first = m_trace_wrapped ? m_trace_next : 0;
+            for (size_t i=0; i<count; i++)
+            {
+                const pool_event& e = m_trace[(first + i) % m_trace.size()];
+                std::fprintf(f, "%llu,%s,%p,%s,%u\n", (unsigned long long)e.nanoseconds, e.op == pool_event::allocate ? "alloc" : "free",
+                             e.address, e.file ? e.file : "", e.line);
+            }
+            return std::fclose(f) == 0;
+        }
+    };
+
+    // Instrumentation used when ECS_POOL_STATS is 0, every hook compiles away
+    struct no_pool_stats
+    {
+        void on_allocate(const void*, size_t, const std::source_location*) {}
+        void on_free(const void*, size_t) {}
+        void on_slab(int) {}
+        void fill(pool_snapshot&) const {}
+        void trace(size_t) {}
+        template <class Visit> void visit_sites(Visit&&) const {}
+        bool dump_trace(const char*) const {return false;}
+    };
+
+#if ECS_POOL_STATS
+    using default_pool_stats = pool_stats;
+#else
+    using default_pool_stats = no_pool_stats;
+#endif
+}
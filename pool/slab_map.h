@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace ecs
+{
+    // Finds the slab holding an address without a back reference in every object: a three level radix tree
+    // over 4 KB pages of the 48 bit address space, like tcmalloc's page map. Slabs start on a page boundary,
+    // so every page they touch belongs to them alone. Nodes are created on first use and never freed, a leaf
+    // covers 16 MB of address space in 32 KB.
+    // Pools on different threads may insert and erase at the same time. find returns nullptr for any address
+    // outside the slabs currently inserted.
+    class slab_map
+    {
+    public:
+        static constexpr unsigned page_shift = 12;
+        static constexpr size_t   page_size  = size_t(1) << page_shift;
+
+        static void insert(const void* begin, size_t bytes, void* slab)
+        {
+            uintptr_t first = (uintptr_t)begin >> page_shift;
+            uintptr_t last = ((uintptr_t)begin + bytes - 1) >> page_shift;
+            if (last >> (3*level_bits)) throw std::length_error("ecs::slab_map: address beyond 48 bits");
+            for (uintptr_t page=first; page<=last; page++) leaf_of(page)->entries[page & level_mask].store(slab, std::memory_order_release);
+        }
+
+        static void erase(const void* begin, size_t bytes)
+        {
+            uintptr_t first = (uintptr_t)begin >> page_shift;
+            uintptr_t last = ((uintptr_t)begin + bytes - 1) >> page_shift;
+            for (uintptr_t page=first; page<=last; page++) leaf_of(page)->entries[page & level_mask].store(nullptr, std::memory_order_relaxed);
+        }
+
+        // nullptr for an address no slab was ever inserted around
+        static void* find(const void* p)
+        {
+            uintptr_t page = (uintptr_t)p >> page_shift;
+            if (page >> (3*level_bits)) return nullptr;
+            node* n = s_root[page >> (2*level_bits)].load(std::memory_order_acquire);
+            if (!n) return nullptr;
+            leaf* l = n->leaves[(page >> level_bits) & level_mask].load(std::memory_order_acquire);
+            if (!l) return nullptr;
+            return l->entries[page & level_mask].load(std::memory_order_acquire);
+        }
+
+    private:
+        static constexpr unsigned  level_bits = 12;
+        static constexpr uintptr_t level_mask = (uintptr_t(1) << level_bits) - 1;
+
+        struct leaf
+        {
+            std::atomic<void*> entries[size_t(1) << level_bits];
+        };
+
+        struct node
+        {
+            std::atomic<leaf*> leaves[size_t(1) << level_bits];
+        };
+
+        static inline std::atomic<node*> s_root[size_t(1) << level_bits];
+
+        // Whoever loses the race to create a node deletes its copy
+        template <class Child>
+        static Child* child(std::atomic<Child*>& slot)
+        {
+            Child* c = slot.load(std::memory_order_acquire);
+            if (c) return c;
+            Child* created = new Child();
+            if (slot.compare_exchange_strong(c, created, std::memory_order_acq_rel, std::memory_order_acquire)) return created;
+            delete created;
+            return c;
+        }
+
+        static leaf* leaf_of(uintptr_t page)
+        {
+            node* n = child(s_root[page >> (2*level_bits)]);
+            return child(n->leaves[(page >> level_bits) & level_mask]);
+        }
+    };
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace ecs
+{
+    // A slab source hands raw memory to the pools.
+    //   void* acquire(size_t bytes, size_t align)          throws std::bad_alloc on failure
+    //   void  release(void* p, size_t bytes, size_t align)
+    //   void  decommit(void* begin, void* end)             returns the pages fully inside [begin, end) to the OS,
+    //                                                      their content reads back as zero
+    //   static constexpr bool can_decommit
+
+    struct heap_slab_source
+    {
+        static constexpr bool can_decommit = false;
+
+        void* acquire(size_t bytes, size_t align)
+        {
+            return ::operator new(bytes, std::align_val_t{align});
+        }
+
+        void release(void* p, size_t, size_t align)
+        {
+            ::operator delete(p, std::align_val_t{align});
+        }
+
+        void decommit(void*, void*) {}
+    };
+
+#if defined(__linux__)
+    struct mmap_slab_source
+    {
+        enum options : unsigned
+        {
+            transparent_huge_pages  = 1,    // madvise(MADV_HUGEPAGE), slabs are 2 MB aligned so THP can back them
+            huge_tlb                = 2,    // MAP_HUGETLB from the reserved hugetlbfs pool, falls back to normal pages
+            populate                = 4,    // MAP_POPULATE, pre-fault the slab when it is created
+        };
+
+        static constexpr bool   can_decommit = true;
+        static constexpr size_t huge_page    = size_t(2) << 20;
+
+        unsigned flags;
+
+        mmap_slab_source(unsigned p_flags = 0) : flags(p_flags) {}
+
+        static size_t page_size()
+        {
+            static const size_t size = (size_t)sysconf(_SC_PAGESIZE);
+            return size;
+        }
+
+        static size_t round_up(size_t value, size_t to) {return (value + to - 1) / to * to;}
+
+        // Slabs are always a whole number of huge pages when huge_tlb is requested, so release can unmap
+        // the same length whether the hugetlb mapping succeeded or not
+        size_t mapping_length(size_t bytes) const {return round_up(bytes, (flags & huge_tlb) ? huge_page : page_size());}
+
+        void* acquire(size_t bytes, size_t align)
+        {
+            size_t length = mapping_length(bytes);
+
+            if (flags & huge_tlb)
+            {
+                int extra = (flags & populate) ? MAP_POPULATE : 0;
+                void* p = mmap(nullptr, length, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB|extra, -1, 0);
+                if (p != MAP_FAILED) return p;
+            }
+
+            // Over-reserve so the slab can be aligned, then unmap the slack on both sides
+            size_t boundary = (flags & transparent_huge_pages) ? huge_page : page_size();
+            if (align > boundary) boundary = align;
+            size_t reserve = length + boundary - page_size();
+            void* raw = mmap(nullptr, reserve, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED) throw std::bad_alloc();
+
+            uintptr_t start = round_up((uintptr_t)raw, boundary);
+            uintptr_t end = start + length;
+            if (start > (uintptr_t)raw) munmap(raw, start - (uintptr_t)raw);
+            if ((uintptr_t)raw + reserve > end) munmap((void*)end, (uintptr_t)raw + reserve - end);
+
+            if (flags & transparent_huge_pages) madvise((void*)start, length, MADV_HUGEPAGE);
+            if (flags & populate) prefault((void*)start, length);
+            return (void*)start;
+        }
+
+        void release(void* p, size_t bytes, size_t)
+        {
+            munmap(p, mapping_length(bytes));
+        }
+
+        // MAP_POPULATE only applies at mmap time, after the alignment trim the pages are faulted in here
+        static void prefault(void* p, size_t length)
+        {
+#if defined(MADV_POPULATE_WRITE)
+            if (madvise(p, length, MADV_POPULATE_WRITE) == 0) return;
+#endif
+            volatile char* bytes = static_cast<char*>(p);
+            for (size_t i=0; i<length; i+=page_size()) bytes[i] = 0;
+        }
+
+        void decommit(void* begin, void* end)
+        {
+            uintptr_t first = round_up((uintptr_t)begin, page_size());
+            uintptr_t last = (uintptr_t)end / page_size() * page_size();
+            if (first < last) madvise((void*)first, last - first, MADV_DONTNEED);
+        }
+    };
+#endif
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+// Fitness proportionate selection in O(1) per draw with Walker's alias method (Vose's construction, O(n)).
+// Every index owns one column of height 1: with probability threshold/2^32 the column gives the index itself,
+// otherwise its alias. One 64 bit random number makes a draw: the high half picks the column, the low half
+// is the coin. Rebuild the sampler when the weights change.
+class alias_sampler
+{
+public:
+	template <class Weights>
+	explicit alias_sampler(const Weights& weights)
+	{
+		size_t n = weights.size();
+		if (n == 0 || n > std::numeric_limits<uint32_t>::max()) throw std::invalid_argument("alias_sampler: invalid population size");
+
+		double total = 0;
+		for (auto w : weights) total += (double)w;
+		if (!(total > 0)) throw std::invalid_argument("alias_sampler: weights must not all be zero");
+
+		m_threshold.resize(n);
+		m_alias.resize(n);
+
+		// Columns below 1 are filled up with the excess of columns above 1
+		std::vector<double> scaled(n);
+		std::vector<uint32_t> small, large;
+		small.reserve(n);
+		large.reserve(n);
+		size_t i = 0;
+		for (auto w : weights)
+		{
+			scaled[i] = (double)w * n / total;
+			if (scaled[i] < 1.0) small.push_back((uint32_t)i);
+			else large.push_back((uint32_t)i);
+			i++;
+		}
+
+		while (!small.empty() && !large.empty())
+		{
+			uint32_t s = small.back();
+			uint32_t l = large.back();
+			small.pop_back();
+			m_threshold[s] = to_threshold(scaled[s]);
+			m_alias[s] = l;
+			scaled[l] -= 1.0 - scaled[s];
+			if (scaled[l] < 1.0)
+			{
+				large.pop_back();
+				small.push_back(l);
+			}
+		}
+
+		// What is left is 1 up to rounding, those columns always give themselves
+		for (uint32_t l : large)
+		{
+			m_threshold[l] = std::numeric_limits<uint32_t>::max();
+			m_alias[l] = l;
+		}
+		for (uint32_t s : small)
+		{
+			m_threshold[s] = std::numeric_limits<uint32_t>::max();
+			m_alias[s] = s;
+		}
+	}
+
+	// rng() must return 64 random bits, like std::mt19937_64
+	template <class Rng>
+	size_t sample(Rng& rng) const
+	{
+		uint64_t r = (uint64_t)rng();
+		uint32_t column = (uint32_t)(((r >> 32) * m_threshold.size()) >> 32);
+		return (uint32_t)r < m_threshold[column] ? column : m_alias[column];
+	}
+
+	template <class Rng>
+	void sample_n(Rng& rng, size_t* out, size_t count) const
+	{
+		for (size_t i=0; i<count; i++) out[i] = sample(rng);
+	}
+
+	size_t size() const { return m_threshold.size(); }
+
+private:
+	std::vector<uint32_t> m_threshold;
+	std::vector<uint32_t> m_alias;
+
+	static uint32_t to_threshold(double p)
+	{
+		double t = p * 4294967296.0;
+		return t >= 4294967295.0 ? std::numeric_limits<uint32_t>::max() : (uint32_t)t;
+	}
+};
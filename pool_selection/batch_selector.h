@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "mul_high.h"
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"). A counter-based generator:
+// block k of a stream is a pure function of (key, k), so any thread can produce any part of the stream
+// without sharing state, and the output does not depend on how the work was split.
+struct philox4x32
+{
+	uint32_t key[2];
+
+	explicit philox4x32(uint64_t seed) : key{(uint32_t)seed, (uint32_t)(seed >> 32)} {}
+
+	// Two 64 bit random numbers for block index k
+	void block(uint64_t k, uint64_t out[2]) const
+	{
+		uint32_t c[4] = {(uint32_t)k, (uint32_t)(k >> 32), 0, 0};
+		uint32_t k0 = key[0], k1 = key[1];
+		for (int round=0; round<10; round++)
+		{
+			uint64_t p0 = (uint64_t)0xD2511F53 * c[0];
+			uint64_t p1 = (uint64_t)0xCD9E8D57 * c[2];
+			uint32_t next[4] = {(uint32_t)(p1 >> 32) ^ c[1] ^ k0, (uint32_t)p1, (uint32_t)(p0 >> 32) ^ c[3] ^ k1, (uint32_t)p0};
+			c[0] = next[0]; c[1] = next[1]; c[2] = next[2]; c[3] = next[3];
+			k0 += 0x9E3779B9;
+			k1 += 0xBB67AE85;
+		}
+		out[0] = (uint64_t)c[1] << 32 | c[0];
+		out[1] = (uint64_t)c[3] << 32 | c[2];
+	}
+};
+
+// Fitness proportionate selection in batches of millions. Draw i of a seed always uses the same Philox output,
+// so select() fills the same indices whatever the number of threads. Each draw is an upper bound search in the
+// cumulative fitnesses with a fixed trip count and no data dependent branch, run on a group of draws at once so
+// the loads of the group overlap and the compiler can vectorize the group.
+class batch_selector
+{
+public:
+	template <class Weights>
+	explicit batch_selector(const Weights& weights)
+	{
+		m_prefix.reserve(weights.size());
+		uint64_t total = 0;
+		for (auto w : weights)
+		{
+			total += (uint64_t)w;
+			m_prefix.push_back(total);
+		}
+		if (m_prefix.empty() || total == 0) throw std::invalid_argument("batch_selector: empty population or zero total fitness");
+
+		m_steps = 0;
+		for (size_t len=m_prefix.size(); len>1; len-=len/2) m_steps++;
+	}
+
+	size_t size() const { return m_prefix.size(); }
+
+	uint64_t total() const { return m_prefix.back(); }
+
+	// Index whose interval of the cumulative fitnesses holds val, val < total()
+	size_t find(uint64_t val) const
+	{
+		const uint64_t* base = m_prefix.data();
+		size_t len = m_prefix.size();
+		while (len > 1)
+		{
+			size_t half = len / 2;
+			base += base[half - 1] <= val ? half : 0;
+			len -= half;
+		}
+		return base - m_prefix.data();
+	}
+
+	// Fills out[0..count) with draws first..first+count of the stream of seed.
+	// threads 0 means one per hardware thread; small batches use fewer.
+	void select(uint64_t seed, size_t* out, size_t count, unsigned threads = 0, uint64_t first = 0) const
+	{
+		if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+		threads = (unsigned)std::min<size_t>(threads, 1 + count / min_per_thread);
+		if (threads == 1) return select_range(philox4x32(seed), first, out, count);
+
+		std::vector<std::thread> workers;
+		workers.reserve(threads - 1);
+		size_t per_thread = ((count + threads - 1) / threads + 1) & ~(size_t)1;    // even, so no block is split
+		for (unsigned t=1; t<threads; t++)
+		{
+			size_t begin = std::min(count, per_thread * t);
+			size_t end = std::min(count, begin + per_thread);
+			workers.emplace_back([this, seed, first, begin, end, out] { select_range(philox4x32(seed), first + begin, out + begin, end - begin); });
+		}
+		select_range(philox4x32(seed), first, out, std::min(count, per_thread));
+		for (std::thread& worker : workers) worker.join();
+	}
+
+	// How often every index would be selected by select(seed, ..., count): counts[i] for i < size()
+	void histogram(uint64_t seed, size_t* counts, size_t count, unsigned threads = 0) const
+	{
+		if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+		threads = (unsigned)std::min<size_t>(threads, 1 + count / min_per_thread);
+		std::vector<std::vector<size_t>> partial(threads, std::vector<size_t>(size()));
+		size_t per_thread = ((count + threads - 1) / threads + 1) & ~(size_t)1;
+
+		auto work = [&](unsigned t)
+		{
+			size_t chunk[4096];
+			size_t begin = std::min(count, per_thread * t);
+			size_t end = std::min(count, begin + per_thread);
+			for (size_t i=begin; i<end; i+=sizeof(chunk)/sizeof(chunk[0]))
+			{
+				size_t n = std::min(end - i, sizeof(chunk)/sizeof(chunk[0]));
+				select_range(philox4x32(seed), i, chunk, n);
+				for (size_t k=0; k<n; k++) partial[t][chunk[k]]++;
+			}
+		};
+		std::vector<std::thread> workers;
+		for (unsigned t=1; t<threads; t++) workers.emplace_back(work, t);
+		work(0);
+		for (std::thread& worker : workers) worker.join();
+
+		std::fill(counts, counts + size(), 0);
+		for (const std::vector<size_t>& p : partial)
+		{
+			for (size_t i=0; i<size(); i++) counts[i] += p[i];
+		}
+	}
+
+private:
+	static constexpr size_t min_per_thread = 1 << 16;
+	static constexpr size_t group = 8;
+
+	std::vector<uint64_t> m_prefix;     // inclusive cumulative fitnesses
+	unsigned m_steps;                   // halvings from the whole population down to one index
+
+	uint64_t scale(uint64_t r) const { return mul_high(r, total()); }
+
+	// Draw index i is word i%2 of Philox block i/2
+	void select_range(const philox4x32& rng, uint64_t first, size_t* out, size_t count) const
+	{
+		size_t i = 0;
+		uint64_t words[2];
+		if (first & 1)
+		{
+			if (count == 0) return;
+			rng.block(first / 2, words);
+			out[i++] = find(scale(words[1]));
+		}
+
+		const uint64_t* prefix = m_prefix.data();
+		for (; i + group <= count; i+=group)
+		{
+			uint64_t val[group];
+			size_t base[group];
+			for (size_t k=0; k<group; k+=2)
+			{
+				rng.block((first + i + k) / 2, words);
+				val[k] = scale(words[0]);
+				val[k + 1] = scale(words[1]);
+			}
+			for (size_t k=0; k<group; k++) base[k] = 0;
+
+			// Same halving sequence for every draw, so the lanes stay in step
+			size_t len = m_prefix.size();
+			for (unsigned s=0; s<m_steps; s++)
+			{
+				size_t half = len / 2;
+				for (size_t k=0; k<group; k++) base[k] += prefix[base[k] + half - 1] <= val[k] ? half : 0;
+				len -= half;
+			}
+			for (size_t k=0; k<group; k++) out[i + k] = base[k];
+		}
+
+		for (; i<count; i++)
+		{
+			uint64_t index = first + i;
+			rng.block(index / 2, words);
+			out[i] = find(scale(words[index & 1]));
+		}
+	}
+};
@@ -0,0 +1,144 @@
+// Fitness proportionate selection: linear scan of the cumulative fitness against the alias sampler, and
+// rebuilding the alias table against Fenwick tree updates when a few fitnesses change every generation,
+// and batch selection by thread count.
+// g++ -std=c++17 -O2 -DNDEBUG benchmark.cpp -o benchmark -pthread
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+#include <thread>
+#include "alias_sampler.h"
+#include "batch_selector.h"
+#include "fenwick_sampler.h"
+
+// The selection loop of main.cpp: walk the fitnesses until the random value falls in one's interval
+static size_t linear_select(const std::vector<size_t>& fitnesses, size_t val)
+{
+	size_t accum = 0;
+	for (size_t i=0; i<fitnesses.size(); i++)
+	{
+		accum += fitnesses[i];
+		if (val < accum) return i;
+	}
+	return fitnesses.size() - 1;
+}
+
+static double ns_since(std::chrono::steady_clock::time_point start, size_t ops)
+{
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ops;
+}
+
+int main()
+{
+	std::printf("%10s %14s %14s %14s %12s\n", "population", "linear ns", "alias ns", "sample_n ns", "build ms");
+	std::mt19937_64 rng(2024);
+	for (size_t n=10; n<=10000000; n*=10)
+	{
+		std::vector<size_t> fitnesses(n);
+		for (size_t& f : fitnesses) f = 1 + rng()%10000;
+		size_t total = std::accumulate(fitnesses.begin(), fitnesses.end(), size_t(0));
+
+		// the scan costs O(n) per draw, keep its run time bounded
+		size_t linear_draws = std::max<size_t>(100, 100000000 / n);
+		size_t draws = 10000000;
+		size_t sink = 0;
+
+		auto startTime = std::chrono::steady_clock::now();
+		for (size_t i=0; i<linear_draws; i++) sink += linear_select(fitnesses, rng() % total);
+		double linear_ns = ns_since(startTime, linear_draws);
+
+		startTime = std::chrono::steady_clock::now();
+		alias_sampler sampler(fitnesses);
+		double build_ms = ns_since(startTime, 1) / 1e6;
+
+		startTime = std::chrono::steady_clock::now();
+		for (size_t i=0; i<draws; i++) sink += sampler.sample(rng);
+		double alias_ns = ns_since(startTime, draws);
+
+		std::vector<size_t> batch(draws);
+		startTime = std::chrono::steady_clock::now();
+		sampler.sample_n(rng, batch.data(), batch.size());
+		double batch_ns = ns_since(startTime, draws);
+		sink += batch[draws/2];
+
+		std::printf("%10zu %14.1f %14.2f %14.2f %12.2f\n", n, linear_ns, alias_ns, batch_ns, build_ms);
+		if (sink == 1) std::printf("\n");
+	}
+
+	// Generations: 10 fitnesses change, then 100 parents are drawn
+	const size_t changes = 10, parents = 100;
+	std::printf("\n%10s %14s %14s %14s\n", "population", "rebuild us", "fenwick us", "ns per op");
+	for (size_t n=10000; n<=1000000; n*=10)
+	{
+		std::vector<size_t> fitnesses(n);
+		for (size_t& f : fitnesses) f = 1 + rng()%10000;
+		size_t generations = std::max<size_t>(10, 10000000 / n);
+		size_t sink = 0;
+
+		auto startTime = std::chrono::steady_clock::now();
+		for (size_t g=0; g<generations; g++)
+		{
+			for (size_t c=0; c<changes; c++) fitnesses[rng() % n] = 1 + rng()%10000;
+			alias_sampler sampler(fitnesses);
+			for (size_t i=0; i<parents; i++) sink += sampler.sample(rng);
+		}
+		double rebuild_us = ns_since(startTime, generations) / 1e3;
+
+		fenwick_sampler tree(fitnesses);
+		generations *= 100;
+		startTime = std::chrono::steady_clock::now();
+		for (size_t g=0; g<generations; g++)
+		{
+			for (size_t c=0; c<changes; c++) tree.update(rng() % n, 1 + rng()%10000);
+			for (size_t i=0; i<parents; i++) sink += tree.sample(rng);
+		}
+		double fenwick_ns = ns_since(startTime, generations);
+
+		std::printf("%10zu %14.1f %14.2f %14.1f\n", n, rebuild_us, fenwick_ns / 1e3, fenwick_ns / (changes + parents));
+		if (sink == 1) std::printf("\n");
+	}
+
+	// Batches of 10^7 selections, same seed for every thread count
+	std::printf("\n%10s %8s %14s %14s\n", "population", "threads", "batch ns", "M/s");
+	unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+	for (size_t n=1000; n<=1000000; n*=1000)
+	{
+		std::vector<size_t> fitnesses(n);
+		for (size_t& f : fitnesses) f = 1 + rng()%10000;
+		batch_selector selector(fitnesses);
+		const size_t draws = 10000000;
+		std::vector<size_t> batch(draws), reference(draws);
+		selector.select(2024, reference.data(), draws, 1);
+		for (unsigned threads=1; ; threads=std::min(hardware, threads*2))
+		{
+			auto startTime = std::chrono::steady_clock::now();
+			selector.select(2024, batch.data(), draws, threads);
+			double ns = ns_since(startTime, draws);
+			std::printf("%10zu %8u %14.2f %14.1f%s\n", n, threads, ns, 1e3 / ns, batch == reference ? "" : "  differs from 1 thread");
+			if (threads == hardware) break;
+		}
+	}
+
+	// Sanity check: observed frequencies against the fitness shares of main.cpp's population
+	std::vector<size_t> fitnesses = {2050, 1800, 1500, 789, 456, 123, 12};
+	double total = std::accumulate(fitnesses.begin(), fitnesses.end(), 0.0);
+	alias_sampler sampler(fitnesses);
+	std::vector<size_t> summary(fitnesses.size());
+	const size_t draws = 10000000;
+	for (size_t i=0; i<draws; i++) summary[sampler.sample(rng)]++;
+	double worst = 0;
+	for (size_t i=0; i<fitnesses.size(); i++) worst = std::max(worst, std::fabs(summary[i] / (double)draws - fitnesses[i] / total));
+	std::printf("largest frequency error over %zu draws: %.5f\n", draws, worst);
+
+	fenwick_sampler tree(fitnesses);
+	std::fill(summary.begin(), summary.end(), 0);
+	for (size_t i=0; i<draws; i++) summary[tree.sample(rng)]++;
+	worst = 0;
+	for (size_t i=0; i<fitnesses.size(); i++) worst = std::max(worst, std::fabs(summary[i] / (double)draws - fitnesses[i] / total));
+	std::printf("fenwick largest frequency error over %zu draws: %.5f\n", draws, worst);
+	return 0;
+}
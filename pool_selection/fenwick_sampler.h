@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "mul_high.h"
+
+// Fitness proportionate selection over weights that keep changing. A Fenwick tree of the integer weights
+// gives update(i, w) and sample() in O(log n) without ever rebuilding; the sums are exact.
+class fenwick_sampler
+{
+public:
+	template <class Weights>
+	explicit fenwick_sampler(const Weights& weights)
+	{
+		m_weights.reserve(weights.size());
+		m_total = 0;
+		for (auto w : weights)
+		{
+			m_weights.push_back((uint64_t)w);
+			m_total += (uint64_t)w;
+		}
+		if (m_weights.empty()) throw std::invalid_argument("fenwick_sampler: empty population");
+
+		// O(n) build: every node pushes its sum to its parent
+		size_t n = m_weights.size();
+		m_tree.assign(n + 1, 0);
+		for (size_t i=1; i<=n; i++)
+		{
+			m_tree[i] += m_weights[i-1];
+			size_t parent = i + (i & (0 - i));
+			if (parent <= n) m_tree[parent] += m_tree[i];
+		}
+		m_top = 1;
+		while (m_top * 2 <= n) m_top *= 2;
+	}
+
+	void update(size_t i, uint64_t weight)
+	{
+		uint64_t delta = weight - m_weights[i];    // wraps around when the weight goes down, so do the sums
+		m_weights[i] = weight;
+		m_total += delta;
+		for (size_t k=i+1; k<m_tree.size(); k+=k & (0 - k)) m_tree[k] += delta;
+	}
+
+	uint64_t weight(size_t i) const { return m_weights[i]; }
+
+	uint64_t total() const { return m_total; }
+
+	size_t size() const { return m_weights.size(); }
+
+	// rng() must return 64 random bits, like std::mt19937_64. The total weight must not be zero.
+	template <class Rng>
+	size_t sample(Rng& rng) const
+	{
+		return find(mul_high((uint64_t)rng(), total()));
+	}
+
+	// Index whose interval of the cumulative weights holds val, val < total()
+	size_t find(uint64_t val) const
+	{
+		size_t pos = 0;
+		for (size_t step=m_top; step>0; step>>=1)
+		{
+			if (pos + step < m_tree.size() && m_tree[pos + step] <= val)
+			{
+				pos += step;
+				val -= m_tree[pos];
+			}
+		}
+		return pos;
+	}
+
+	// Draws up to count distinct indices, each with probability proportional to its weight among those
+	// not drawn yet. Weights are restored afterwards. Returns how many were drawn, fewer once only zero
+	// weights are left.
+	template <class Rng>
+	size_t sample_without_replacement(Rng& rng, size_t* out, size_t count)
+	{
+		std::vector<uint64_t> removed;
+		removed.reserve(count);
+		size_t drawn = 0;
+		for (; drawn<count && total()>0; drawn++)
+		{
+			size_t i = sample(rng);
+			out[drawn] = i;
+			removed.push_back(m_weights[i]);
+			update(i, 0);
+		}
+		for (size_t k=0; k<drawn; k++) update(out[k], removed[k]);
+		return drawn;
+	}
+
+private:
+	std::vector<uint64_t> m_weights;
+	std::vector<uint64_t> m_tree;   // 1 based
+	uint64_t m_total;
+	size_t m_top;                   // highest power of two not above the size
+};
@@ -20,14 +20,21 @@ freely, subject to the following restrictions:
 3. This notice may not be removed or altered from any source distribution.
 */
 
-#include <iostream>
-#include <vector>
-#include <numeric>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <ctime>
-int main()
+#include <numeric>
+#include <vector>
+#include "batch_selector.h"
+
+// pool_selection [draws] [seed] [threads]
+// The same seed gives the same selections whatever the number of threads.
+int main(int argc, char** argv)
 {
-	// Seed random generator (std::rand is awful but's what we got)
-	std::srand(std::time(0));
+	size_t draws = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+	uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : (uint64_t)std::time(0);
+	unsigned threads = argc > 3 ? (unsigned)std::strtoul(argv[3], nullptr, 10) : 0;
 
 	// array of fitness values
 	std::vector<size_t> fitnesses;
@@ -43,48 +50,19 @@ int main()
 	std::vector<size_t> summary(fitnesses.size());
 
 	// Sum of all fitnesses
-	size_t total = std::accumulate(fitnesses.begin(), fitnesses.end(), 0);
-
-	while (true)
-	{
-		// Offset for the next interval
-		size_t accum = fitnesses[0];
-
-		// Pick a random number between 0 and the sum of all fitnesses
-		// You should really consider using a random generator other than std::rand()
-		size_t val = std::rand()%((int)total);
-
-		// flags
-		size_t selected = 0;
-		bool found = false;
+	size_t total = std::accumulate(fitnesses.begin(), fitnesses.end(), size_t(0));
 
-		// If the random value is in the range of the first value, select the first value
-		if (val<accum)
-		{
-			selected = 0;
-			found = true;
-		}
+	// Every draw picks a value between 0 and the sum of all fitnesses and selects the fitness whose interval holds it
+	batch_selector selector(fitnesses);
+	auto startTime = std::chrono::steady_clock::now();
+	selector.histogram(seed, summary.data(), draws, threads);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
 
-		// Iterate all other firnesses and look for a matching range
-		for (size_t i=1; i<fitnesses.size() && !found; i++)
-		{
-			// If the Random value is more than the offset but less than offset+current_fitness, select and exit
-			if (val>=accum && val < accum + fitnesses[i])
-			{
-				selected = i;
-				found = true;
-				break;
-			}
-			accum += fitnesses[i];
-		}
-
-		summary[selected] += 1;
-
-		system("cls");
-		for (size_t i=0; i<summary.size(); i++)
-		{
-			std::cout << summary[i] << std::endl;
-		}
+	std::printf("%zu selections, seed %llu, %.1f M/s\n", draws, (unsigned long long)seed, draws / seconds / 1e6);
+	std::printf("%6s %10s %12s %10s %10s\n", "index", "fitness", "selected", "observed", "expected");
+	for (size_t i=0; i<summary.size(); i++)
+	{
+		std::printf("%6zu %10zu %12zu %10.5f %10.5f\n", i, fitnesses[i], summary[i], draws ? summary[i] / (double)draws : 0.0, fitnesses[i] / (double)total);
 	}
- 	return 0;
+	return 0;
 }
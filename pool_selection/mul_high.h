@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+#if !defined(__SIZEOF_INT128__) && defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#include <intrin.h>
+#endif
+
+// High 64 bits of the 128 bit product a * b, used to scale a random number into [0, b) without a division.
+// unsigned __int128 only exists on GCC and Clang for 64 bit targets; MSVC has an intrinsic, anything else
+// adds up the four 32 x 32 bit partial products.
+inline uint64_t mul_high(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+	return (uint64_t)(((unsigned __int128)a * b) >> 64);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+	return __umulh(a, b);
+#else
+	uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+	uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+	uint64_t lo_lo = a_lo * b_lo;
+	uint64_t hi_lo = a_hi * b_lo;
+	uint64_t lo_hi = a_lo * b_hi;
+	uint64_t hi_hi = a_hi * b_hi;
+	uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;   // cannot overflow
+	return hi_hi + (hi_lo >> 32) + (cross >> 32);
+#endif
+}
@@ -0,0 +1,227 @@
+// Messages per second through the demultiplexer into processes, and push to handling latency, for 1..N
+// producer threads. One thread runs the demultiplexer's update, another drains the processes.
+// Then 1000 processes with a skewed message distribution, drained by one thread polling all of them like
+// main.cpp used to, and by the work-stealing scheduler at 1..N threads.
+// g++ -std=c++17 -O2 -DNDEBUG -Iinclude benchmark.cpp src/demultiplexer.cpp src/process.cpp src/scheduler.cpp -o benchmark -pthread
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include "demultiplexer.h"
+#include "process.h"
+#include "scheduler.h"
+
+namespace
+{
+    uint64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Records how long every message took from push to handling, msg.data is the push time
+    class timing_process : public process
+    {
+        public:
+            timing_process(int id) : process(id, 4096) {}
+
+            std::vector<float> latency;
+
+        protected:
+            void on_message(const message& msg) override
+            {
+                latency.push_back((float)(now_ns() - msg.data));
+            }
+    };
+
+    const size_t process_count = 8;
+    const size_t messages_per_producer = 1000000;
+
+    void run(unsigned producers)
+    {
+        demultiplexer demu(4096);
+        std::vector<std::unique_ptr<timing_process>> procs;
+        for (size_t i=0; i<process_count; i++)
+        {
+            procs.emplace_back(new timing_process((int)i));
+            procs.back()->latency.reserve(producers * messages_per_producer / process_count + messages_per_producer);
+            demu.subscribe(procs.back().get());
+        }
+
+        const size_t total = producers * messages_per_producer;
+        std::atomic<bool> start {false};
+        std::atomic<size_t> handled {0};
+        std::atomic<size_t> full_retries {0};
+
+        std::vector<std::thread> threads;
+        for (unsigned p=0; p<producers; p++)
+        {
+            threads.emplace_back([&, p]
+            {
+                while (!start.load(std::memory_order_acquire)) std::this_thread::yield();
+                size_t retries = 0;
+                for (size_t i=0; i<messages_per_producer; i++)
+                {
+                    message msg;
+                    msg.type = (i + p) % process_count;
+                    msg.data = now_ns();
+                    while (!demu.push(msg))
+                    {
+                        retries++;
+                        std::this_thread::yield();
+                    }
+                }
+                full_retries += retries;
+            });
+        }
+        threads.emplace_back([&]
+        {
+            while (handled.load(std::memory_order_acquire) < total)
+            {
+                if (demu.update() == 0) std::this_thread::yield();
+            }
+        });
+        threads.emplace_back([&]
+        {
+            size_t count = 0;
+            while (count < total)
+            {
+                size_t n = 0;
+                for (auto& proc : procs) n += proc->update();
+                count += n;
+                handled.store(count, std::memory_order_release);
+                if (n == 0) std::this_thread::yield();
+            }
+        });
+
+        uint64_t startTime = now_ns();
+        start.store(true, std::memory_order_release);
+        for (std::thread& thread : threads) thread.join();
+        double seconds = (now_ns() - startTime) / 1e9;
+
+        std::vector<float> latency;
+        latency.reserve(total);
+        for (auto& proc : procs) latency.insert(latency.end(), proc->latency.begin(), proc->latency.end());
+        auto percentile = [&](double q)
+        {
+            size_t k = std::min(latency.size() - 1, (size_t)(latency.size() * q));
+            std::nth_element(latency.begin(), latency.begin() + k, latency.end());
+            return latency[k] / 1e3;
+        };
+        double p50 = percentile(0.5), p99 = percentile(0.99), p999 = percentile(0.999);
+        std::printf("%9u %12.2f %10.1f %10.1f %10.1f %12zu\n", producers, total / seconds / 1e6, p50, p99, p999, full_retries.load());
+        std::fflush(stdout);
+    }
+
+    // A little work per message, and a count the main thread can read while the process runs
+    class work_process : public process
+    {
+        public:
+            work_process(int id) : process(id, 256) {}
+
+            std::atomic<size_t> handled {0};
+            uint64_t state = 1;
+
+        protected:
+            void on_message(const message& msg) override
+            {
+                for (int i=0; i<100; i++) state = state * 6364136223846793005ULL + msg.data;
+                handled.store(handled.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+    };
+
+    const size_t skewed_processes = 1000;
+    const size_t skewed_messages = 2000000;
+
+    // threads 0 runs the polling loop instead of the scheduler
+    void run_skewed(const std::vector<uint32_t>& types, unsigned threads)
+    {
+        demultiplexer demu(1024);
+        std::vector<std::unique_ptr<work_process>> procs;
+        scheduler sched(threads ? threads : 1);
+        for (size_t i=0; i<skewed_processes; i++)
+        {
+            procs.emplace_back(new work_process((int)i));
+            demu.subscribe(procs.back().get());
+            if (threads) sched.add(procs.back().get());
+        }
+
+        std::atomic<bool> done {false};
+        size_t polls = 0, empty_polls = 0;
+        std::thread poller;
+        if (threads) sched.start();
+        else poller = std::thread([&]
+        {
+            while (!done.load(std::memory_order_acquire))
+            {
+                for (auto& proc : procs)
+                {
+                    polls++;
+                    if (proc->update() == 0) empty_polls++;
+                }
+            }
+        });
+
+        // this thread produces and runs the demultiplexer
+        uint64_t startTime = now_ns();
+        for (size_t i=0; i<types.size(); i++)
+        {
+            message msg;
+            msg.type = types[i];
+            msg.data = i;
+            while (!demu.push(msg))
+            {
+                if (demu.update() == 0) std::this_thread::yield();
+            }
+        }
+        for (;;)
+        {
+            demu.update();
+            size_t handled = 0;
+            for (auto& proc : procs) handled += proc->handled.load(std::memory_order_acquire);
+            if (handled == types.size()) break;
+            std::this_thread::yield();
+        }
+        double seconds = (now_ns() - startTime) / 1e9;
+
+        done = true;
+        if (threads)
+        {
+            sched.stop();
+            polls = sched.updates();
+        }
+        else poller.join();
+
+        if (threads) std::printf("%-10s %8u %12.2f %14zu %14s\n", "scheduler", threads, types.size() / seconds / 1e6, polls, "0");
+        else std::printf("%-10s %8u %12.2f %14zu %14zu\n", "polling", 1u, types.size() / seconds / 1e6, polls, empty_polls);
+        std::fflush(stdout);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    unsigned max_producers = argc > 1 ? (unsigned)std::atoi(argv[1]) : std::max(4u, std::thread::hardware_concurrency());
+    std::printf("%zu processes, %zu messages per producer\n", process_count, messages_per_producer);
+    std::printf("%9s %12s %10s %10s %10s %12s\n", "producers", "Mmsg/s", "p50 us", "p99 us", "p999 us", "full retries");
+    for (unsigned producers=1; producers<=max_producers; producers++) run(producers);
+
+    // Zipf distributed types: the hottest process gets about 13% of the messages, most get a handful
+    std::vector<double> weights(skewed_processes);
+    for (size_t i=0; i<skewed_processes; i++) weights[i] = 1.0 / (i + 1);
+    std::discrete_distribution<uint32_t> zipf(weights.begin(), weights.end());
+    std::mt19937 rng(2024);
+    std::vector<uint32_t> types(skewed_messages);
+    for (uint32_t& type : types) type = zipf(rng);
+
+    std::printf("\n%zu processes, %zu messages, Zipf distributed\n", skewed_processes, skewed_messages);
+    std::printf("%-10s %8s %12s %14s %14s\n", "consumer", "threads", "Mmsg/s", "updates", "empty updates");
+    run_skewed(types, 0);
+    for (unsigned threads=1; threads<=max_producers; threads*=2) run_skewed(types, threads);
+    return 0;
+}
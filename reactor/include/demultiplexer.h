@@ -1,34 +1,43 @@
 #ifndef MULTIPLEXER_H
 #define MULTIPLEXER_H
 
+#include <deque>
+#include <memory>
 #include "queue.h"
 
 class process;
 
+// Routes every message to the process subscribed under its type. push may be called from any number of
+// threads at once, every type has its own lock-free multi producer inbox. update moves the inboxes into the
+// processes and must run on one thread at a time, it is the single producer of every process queue.
+// Subscribe all processes before the producers start.
 class demultiplexer
 {
     public:
-                demultiplexer();
+                demultiplexer(size_t capacity = 1024);
         virtual ~demultiplexer();
 
-        void push (const message& msg)
+        // false when the inbox of msg.type is full, the message is not queued
+        bool push (const message& msg)
         {
-            queue[msg.type].push_front(msg);
+            return queue[msg.type]->try_push(msg);
         }
 
-        void update();
+        // Number of messages handed to processes
+        size_t update();
 
         void subscribe(process* proc)
         {
             processes.push_back(proc);
-            queue.resize(queue.size()+1);
+            queue.emplace_back(new mpmc_queue<message>(m_capacity));
         }
 
     protected:
-        std::deque<std::deque<message>> queue;
+        std::deque<std::unique_ptr<mpmc_queue<message>>> queue;
         std::deque<process*> processes;
 
     private:
+        size_t m_capacity;
 };
 
 #endif // MULTIPLEXER_H
@@ -1,44 +1,66 @@
 #ifndef PROCESS_H
 #define PROCESS_H
-#include <assert.h>
+#include <atomic>
+#include <iostream>
 #include "queue.h"
 
+class scheduler;
+
+// Receives messages through a lock-free single producer, single consumer queue: one thread pushes (the
+// demultiplexer's update) while another runs update. Added to a scheduler, a push wakes the process and a
+// worker runs update.
 class process
 {
     public:
-                    process(int id);
+                    process(int id, size_t capacity = 1024);
         virtual     ~process();
 
-        void lock() {m_locked = true;}
-        void unlock() {m_locked = false;}
-        const bool& locked() { return m_locked; }
-
-        void push(const message& msg)
+        // producer side. false when the queue is full
+        bool push(const message& msg)
         {
-            assert(m_locked && "Process mutex not locked.");
-            queue.push_front(msg);
+            if (!queue.try_push(msg)) return false;
+            if (m_scheduler) notify();
+            return true;
         }
 
-        void update()
-        {
-            if (queue.size()<1 || m_locked) return;
+        // producer side
+        bool full() {return queue.full();}
 
-            lock();
+        bool pending() const {return !queue.empty();}
 
-            for (message& msg : queue)
+        // consumer side. Handles at most one queue worth of messages, returns how many
+        size_t update()
+        {
+            size_t handled = 0;
+            message msg;
+            while (handled < queue.capacity() && queue.try_pop(msg))
             {
-                std::cout << msg.type <<std::endl;
+                on_message(msg);
+                handled++;
             }
-            queue.clear();
-
-            unlock();
+            return handled;
         }
 
+        int id() const {return m_id;}
+
+        // Scheduler side: the process is queued or running while claimed, claim fails if it already is
+        void attach(scheduler* sched) {m_scheduler = sched;}
+        bool claim() {return !m_scheduled.load(std::memory_order_relaxed) && !m_scheduled.exchange(true, std::memory_order_acquire);}
+        void release() {m_scheduled.store(false, std::memory_order_release);}
+
     protected:
-        std::deque<message> queue;
+        virtual void on_message(const message& msg)
+        {
+            std::cout << msg.type <<std::endl;
+        }
+
+        spsc_queue<message> queue;
         int m_id;
-        bool m_locked;
     private:
+        scheduler* m_scheduler = nullptr;
+        std::atomic<bool> m_scheduled {false};
+
+        void notify();
 };
 
 #endif // PROCESS_H
@@ -1,24 +1,184 @@
 #ifndef QUEUE_H
 #define QUEUE_H
 
-#include <iostream>
-#include <deque>
+#include <atomic>
+#include <cstddef>
+#include <memory>
 
 struct message
 {
-    size_t type;
+    size_t type = 0;
+    size_t data = 0;
+};
+
+// Bounded lock-free ring buffers. The capacity is rounded up to a power of two and never grows:
+// try_push returns false when the ring is full and try_pop when it is empty, callers decide whether to
+// retry, drop or back off. The producer and consumer indices live on separate cache lines.
+
+// One producer thread, one consumer thread (Lamport's ring). Each side keeps a copy of the other's index
+// and only reads the shared one when its copy says full or empty.
+template <class T>
+class spsc_queue
+{
+    public:
+        explicit spsc_queue(size_t capacity) : m_mask(round_up(capacity) - 1), m_slots(new T[m_mask + 1]) {}
+
+        spsc_queue(const spsc_queue&) = delete;
+        spsc_queue& operator=(const spsc_queue&) = delete;
+
+        // producer only
+        bool try_push(const T& value)
+        {
+            size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head_cache > m_mask)
+            {
+                m_head_cache = m_head.load(std::memory_order_acquire);
+                if (tail - m_head_cache > m_mask) return false;
+            }
+            m_slots[tail & m_mask] = value;
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // producer only, true when the next try_push would fail
+        bool full()
+        {
+            size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head_cache > m_mask) m_head_cache = m_head.load(std::memory_order_acquire);
+            return tail - m_head_cache > m_mask;
+        }
+
+        // consumer only
+        bool try_pop(T& value)
+        {
+            size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail_cache)
+            {
+                m_tail_cache = m_tail.load(std::memory_order_acquire);
+                if (head == m_tail_cache) return false;
+            }
+            value = m_slots[head & m_mask];
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Either side. Only a hint while the other side is running.
+        bool empty() const {return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);}
 
+        size_t capacity() const {return m_mask + 1;}
+
+    private:
+        const size_t m_mask;
+        std::unique_ptr<T[]> m_slots;
+        alignas(64) std::atomic<size_t> m_head {0};
+        size_t m_tail_cache = 0;                        // consumer's copy of m_tail
+        alignas(64) std::atomic<size_t> m_tail {0};
+        size_t m_head_cache = 0;                        // producer's copy of m_head
+        char m_padding[64 - sizeof(size_t) * 2];
+
+        static size_t round_up(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity) size *= 2;
+            return size;
+        }
 };
 
-class queue
+// Any number of producer and consumer threads (Vyukov's bounded queue). Every slot carries a sequence number
+// telling whether it is ready to be written or read in the current lap; a thread claims a slot with one
+// compare-exchange on the shared index and no thread ever waits for another inside try_push or try_pop.
+template <class T>
+class mpmc_queue
 {
     public:
-        queue();
-        virtual ~queue();
+        explicit mpmc_queue(size_t capacity) : m_mask(round_up(capacity) - 1), m_slots(new slot[m_mask + 1])
+        {
+            for (size_t i=0; i<=m_mask; i++) m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        mpmc_queue(const mpmc_queue&) = delete;
+        mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+        bool try_push(const T& value)
+        {
+            size_t pos = m_tail.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                slot& s = m_slots[pos & m_mask];
+                size_t sequence = s.sequence.load(std::memory_order_acquire);
+                ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)pos;
+                if (diff == 0)
+                {
+                    if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        s.value = value;
+                        s.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;       // a lap behind: full
+                }
+                else
+                {
+                    pos = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
 
-    protected:
+        bool try_pop(T& value)
+        {
+            size_t pos = m_head.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                slot& s = m_slots[pos & m_mask];
+                size_t sequence = s.sequence.load(std::memory_order_acquire);
+                ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)(pos + 1);
+                if (diff == 0)
+                {
+                    if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        value = s.value;
+                        s.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;       // not written yet: empty
+                }
+                else
+                {
+                    pos = m_head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Only a hint while other threads are running
+        bool empty() const {return m_head.load(std::memory_order_acquire) >= m_tail.load(std::memory_order_acquire);}
+
+        size_t capacity() const {return m_mask + 1;}
 
     private:
+        struct slot
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        const size_t m_mask;
+        std::unique_ptr<slot[]> m_slots;
+        alignas(64) std::atomic<size_t> m_head {0};
+        alignas(64) std::atomic<size_t> m_tail {0};
+        char m_padding[64 - sizeof(size_t)];
+
+        static size_t round_up(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity) size *= 2;
+            return size;
+        }
 };
 
 #endif // QUEUE_H
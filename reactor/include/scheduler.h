@@ -0,0 +1,86 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "queue.h"
+
+class process;
+
+// Runs process::update on a pool of worker threads. A process is queued only when a message arrives while it
+// is idle (process::push wakes it), so idle processes cost nothing and a process never runs on two threads at
+// once. Every worker owns a Chase-Lev deque: it pushes and pops processes at the bottom, idle workers steal
+// from the top. Wake-ups from other threads go through a shared injection queue. Workers with nothing to do
+// sleep on a condition variable.
+// Add every process before start. Stop once the producers are done and before destroying the processes.
+class scheduler
+{
+    public:
+                scheduler(unsigned threads = 0);
+        virtual ~scheduler();
+
+        void add(process* proc);
+
+        void start();
+        void stop();
+
+        // Pushes only wake processes while the workers run
+        bool running() const {return m_running.load(std::memory_order_seq_cst);}
+
+        // Called by process::push after claiming proc, queues it for a worker
+        void wake(process* proc);
+
+        // Number of process::update calls so far
+        size_t updates() const {return m_updates.load(std::memory_order_relaxed);}
+
+    protected:
+        // Chase-Lev work-stealing deque (Lê et al., "Correct and efficient work-stealing for weak memory models").
+        // Never grows: a process is in at most one deque, so the number of processes bounds it.
+        class work_deque
+        {
+            public:
+                explicit work_deque(size_t capacity);
+
+                // owner only
+                void push(process* proc);
+                process* pop();
+
+                // any thread
+                process* steal();
+                bool empty() const;
+
+            private:
+                const size_t m_mask;
+                std::unique_ptr<std::atomic<process*>[]> m_slots;
+                alignas(64) std::atomic<ptrdiff_t> m_top {0};
+                alignas(64) std::atomic<ptrdiff_t> m_bottom {0};
+        };
+
+        std::vector<process*> processes;
+
+    private:
+        unsigned m_thread_count;
+        std::vector<std::thread> m_threads;
+        std::vector<std::unique_ptr<work_deque>> m_deques;
+        std::unique_ptr<mpmc_queue<process*>> m_injected;
+        std::atomic<size_t> m_updates {0};
+
+        std::mutex m_mutex;
+        std::condition_variable m_idle;
+        std::atomic<unsigned> m_sleeping {0};
+        std::atomic<size_t> m_epoch {0};        // bumped under m_mutex on every wake-up of a sleeper
+        std::atomic<bool> m_stopping {false};
+        std::atomic<bool> m_running {false};
+
+        void run(unsigned index);
+        process* find_work(unsigned index, unsigned& victim);
+        bool work_queued() const;
+        void notify();
+};
+
+#endif // SCHEDULER_H
@@ -1,5 +1,6 @@
 #include "demultiplexer.h"
 #include "process.h"
+#include "scheduler.h"
 
 using namespace std;
 
@@ -11,6 +12,13 @@ int main()
     demu.subscribe(&pro1);
     demu.subscribe(&pro2);
 
+    // the processes run on worker threads whenever they have messages
+    scheduler       sched;
+    sched.add(&pro0);
+    sched.add(&pro1);
+    sched.add(&pro2);
+    sched.start();
+
     while (true)
     {
         for (int i=0; i<3; i++)
@@ -19,13 +27,10 @@ int main()
             {
                 message msg;
                 msg.type = k;
-                demu.push(msg); // not thread safe. process uses a mock lock instead of mutex
+                while (!demu.push(msg)) demu.update();  // any thread may push, the inboxes are lock-free
             }
         }
         demu.update();
-        pro0.update();
-        pro1.update();
-        pro2.update();
     }
 
 
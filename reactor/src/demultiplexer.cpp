@@ -1,7 +1,7 @@
 #include "demultiplexer.h"
 #include "process.h"
 
-demultiplexer::demultiplexer()
+demultiplexer::demultiplexer(size_t capacity) : m_capacity(capacity)
 {
     //ctor
 }
@@ -11,16 +11,18 @@ demultiplexer::~demultiplexer()
     //dtor
 }
 
-void demultiplexer::update()
+size_t demultiplexer::update()
 {
-    for (size_t k=0; k<processes.size() && !processes[k]->locked(); k++)
+    size_t moved = 0;
+    for (size_t k=0; k<processes.size(); k++)
     {
-        processes[k]->lock();
-        for ( const message& msg : queue[k])
+        // Nothing else pushes to the process, so a message taken from the inbox always finds room
+        message msg;
+        while (!processes[k]->full() && queue[k]->try_pop(msg))
         {
             processes[k]->push(msg);
+            moved++;
         }
-        processes[k]->unlock();
-        queue[k].clear();
     }
+    return moved;
 }
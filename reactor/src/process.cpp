@@ -1,11 +1,18 @@
 #include "process.h"
+#include "scheduler.h"
 
-process::process(int id) : m_id(id)
+process::process(int id, size_t capacity) : queue(capacity), m_id(id)
 {
-    m_locked = false;
 }
 
 process::~process()
 {
     //dtor
 }
+
+void process::notify()
+{
+    // Pairs with the fence a worker runs between releasing the process and checking for messages
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_scheduler->running() && claim()) m_scheduler->wake(this);
+}
@@ -1,11 +0,0 @@
-#include "queue.h"
-
-queue::queue()
-{
-    //ctor
-}
-
-queue::~queue()
-{
-    //dtor
-}
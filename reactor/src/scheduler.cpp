@@ -0,0 +1,197 @@
+#include "scheduler.h"
+#include "process.h"
+
+namespace
+{
+    // Which worker of which scheduler the calling thread is, so wake-ups from a worker go to its own deque
+    thread_local const scheduler* current_scheduler = nullptr;
+    thread_local unsigned current_worker = 0;
+}
+
+scheduler::work_deque::work_deque(size_t capacity) : m_mask([capacity]
+{
+    size_t size = 2;
+    while (size < capacity) size *= 2;
+    return size - 1;
+}()), m_slots(new std::atomic<process*>[m_mask + 1])
+{
+}
+
+void scheduler::work_deque::push(process* proc)
+{
+    ptrdiff_t bottom = m_bottom.load(std::memory_order_relaxed);
+    m_slots[bottom & m_mask].store(proc, std::memory_order_relaxed);
+    m_bottom.store(bottom + 1, std::memory_order_release);
+}
+
+process* scheduler::work_deque::pop()
+{
+    ptrdiff_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    ptrdiff_t top = m_top.load(std::memory_order_relaxed);
+    if (top > bottom)
+    {
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    process* proc = m_slots[bottom & m_mask].load(std::memory_order_relaxed);
+    if (top == bottom)
+    {
+        // last one, race the thieves for it
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) proc = nullptr;
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return proc;
+}
+
+process* scheduler::work_deque::steal()
+{
+    ptrdiff_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    ptrdiff_t bottom = m_bottom.load(std::memory_order_acquire);
+    if (top >= bottom) return nullptr;
+    process* proc = m_slots[top & m_mask].load(std::memory_order_relaxed);
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+    return proc;
+}
+
+bool scheduler::work_deque::empty() const
+{
+    return m_top.load(std::memory_order_acquire) >= m_bottom.load(std::memory_order_acquire);
+}
+
+scheduler::scheduler(unsigned threads) : m_thread_count(threads ? threads : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+scheduler::~scheduler()
+{
+    stop();
+}
+
+void scheduler::add(process* proc)
+{
+    processes.push_back(proc);
+    proc->attach(this);
+}
+
+void scheduler::start()
+{
+    if (!m_threads.empty()) return;
+    m_stopping = false;
+    m_deques.clear();
+    for (unsigned i=0; i<m_thread_count; i++) m_deques.emplace_back(new work_deque(processes.size()));
+    m_injected.reset(new mpmc_queue<process*>(processes.size()));
+
+    // Pushes wake processes from now on, the ones that got messages before are queued here
+    m_running.store(true, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (process* proc : processes)
+    {
+        if (proc->pending() && proc->claim()) m_injected->try_push(proc);
+    }
+    for (unsigned i=0; i<m_thread_count; i++) m_threads.emplace_back(&scheduler::run, this, i);
+}
+
+void scheduler::stop()
+{
+    if (m_threads.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_idle.notify_all();
+    for (std::thread& thread : m_threads) thread.join();
+    m_threads.clear();
+    m_running = false;
+
+    // whatever was queued is picked up again by the next start
+    for (process* proc : processes) proc->release();
+}
+
+void scheduler::wake(process* proc)
+{
+    if (current_scheduler == this) m_deques[current_worker]->push(proc);
+    else m_injected->try_push(proc);    // cannot fail, every process is queued at most once
+    notify();
+}
+
+void scheduler::notify()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed) == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_epoch.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_idle.notify_one();
+}
+
+bool scheduler::work_queued() const
+{
+    if (!m_injected->empty()) return true;
+    for (const std::unique_ptr<work_deque>& deque : m_deques)
+    {
+        if (!deque->empty()) return true;
+    }
+    return false;
+}
+
+process* scheduler::find_work(unsigned index, unsigned& victim)
+{
+    process* proc = m_deques[index]->pop();
+    if (proc) return proc;
+    if (m_injected->try_pop(proc)) return proc;
+
+    // every other worker once, from an offset that moves on by one each time
+    unsigned others = m_thread_count - 1;
+    unsigned start = victim++;
+    for (unsigned k=0; k<others; k++)
+    {
+        proc = m_deques[(index + 1 + (start + k) % others) % m_thread_count]->steal();
+        if (proc) return proc;
+    }
+    return nullptr;
+}
+
+void scheduler::run(unsigned index)
+{
+    current_scheduler = this;
+    current_worker = index;
+    unsigned victim = 0;
+
+    while (!m_stopping.load(std::memory_order_acquire))
+    {
+        process* proc = find_work(index, victim);
+        if (proc)
+        {
+            proc->update();
+            m_updates.fetch_add(1, std::memory_order_relaxed);
+
+            // more may have arrived meanwhile: requeue it here, unless a producer wakes it first
+            proc->release();
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (proc->pending() && proc->claim())
+            {
+                m_deques[index]->push(proc);
+                notify();
+            }
+            continue;
+        }
+
+        // Sleep. Counting as a sleeper before looking once more means a wake-up either sees the count or
+        // its process is seen here.
+        size_t epoch = m_epoch.load(std::memory_order_relaxed);
+        m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!work_queued())
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_idle.wait(lock, [&] {return m_epoch.load(std::memory_order_relaxed) != epoch || m_stopping.load(std::memory_order_relaxed);});
+        }
+        m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    current_scheduler = nullptr;
+}